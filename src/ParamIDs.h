@@ -8,5 +8,24 @@ inline constexpr auto damp { "damp" };
 inline constexpr auto width { "stereo" };
 inline constexpr auto mix { "mix" };
 inline constexpr auto freeze { "freeze" };
+inline constexpr auto tailRate { "tailRate" };
+inline constexpr auto mode { "mode" };
+inline constexpr auto morph { "morph" };
+inline constexpr auto roomWidth { "roomWidth" };
+inline constexpr auto roomLength { "roomLength" };
+inline constexpr auto roomHeight { "roomHeight" };
+inline constexpr auto leftWall { "leftWall" };
+inline constexpr auto rightWall { "rightWall" };
+inline constexpr auto frontWall { "frontWall" };
+inline constexpr auto backWall { "backWall" };
+inline constexpr auto floor { "floor" };
+inline constexpr auto ceiling { "ceiling" };
+inline constexpr auto bandDecay { "bandDecay" };
+inline constexpr auto lowDecay { "lowDecay" };
+inline constexpr auto midDecay { "midDecay" };
+inline constexpr auto highDecay { "highDecay" };
+inline constexpr auto lowCrossover { "lowCrossover" };
+inline constexpr auto highCrossover { "highCrossover" };
+inline constexpr auto reflections { "reflections" };
 
 } // namespace ParamIDs
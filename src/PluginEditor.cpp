@@ -1,11 +1,15 @@
 #include "PluginEditor.h"
+#include "ParamIDs.h"
 #include "PluginProcessor.h"
 
 PluginEditor::PluginEditor (PluginProcessor& p, juce::UndoManager& um)
     : AudioProcessorEditor (&p)
     , processor (p)
     , undoManager (um)
-    , editorContent (p, um)
+    , frameScheduler (*this)
+    , editorContent (p, um, frameScheduler)
+    , analyzer (p.getAnalyzerFeed())
+    , waveformView (p.getDryHistory(), p.getWetHistory())
     , numericInputFilter(0.0f, 100.0f, 2)  // min=0, max=100, 2 decimal places
 {
     constexpr auto ratio = static_cast<double> (defaultWidth) / defaultHeight;
@@ -16,7 +20,11 @@ PluginEditor::PluginEditor (PluginProcessor& p, juce::UndoManager& um)
     editorContent.setSize (defaultWidth, defaultHeight);
 
     addAndMakeVisible (editorContent);
-    addAndMakeVisible (processor.getAnalyzer());
+    addAndMakeVisible (analyzer);
+    addAndMakeVisible (waveformView);
+
+    analyzer.setFrameScheduler (&frameScheduler);
+    waveformView.setFrameScheduler (&frameScheduler);
 
     // Initialize the text boxes
     textBox1.setMultiLine (false);
@@ -73,6 +81,112 @@ PluginEditor::PluginEditor (PluginProcessor& p, juce::UndoManager& um)
     addAndMakeVisible (unitLabel1);
     addAndMakeVisible (unitLabel2);
     addAndMakeVisible (unitLabel3);
+
+    // Reverb mode and the impulse response the Convolution mode plays. The
+    // items have to be there before the attachment syncs the selection
+    if (auto* modeParameter = dynamic_cast<juce::AudioParameterChoice*> (p.getPluginState().getParameter (ParamIDs::mode)))
+        modeBox.addItemList (modeParameter->choices, 1);
+
+    modeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (p.getPluginState(), ParamIDs::mode, modeBox);
+
+    wallsButton.setTooltip ("What each wall of the Room mode's room is made of");
+    wallsButton.onClick = [this] { showWallsMenu(); };
+
+    loadIrButton.onClick = [this] { chooseImpulseResponse (false); };
+    loadMorphIrButton.onClick = [this] { showMorphIrMenu(); };
+    updateLoadIrButtons();
+
+    morphSlider.setTextBoxStyle (juce::Slider::TextBoxRight, false, 60, 24);
+    morphAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (p.getPluginState(), ParamIDs::morph, morphSlider);
+
+    minimumPhaseButton.setTooltip ("Minimum-phase head: tightens the direct sound of the impulse response");
+    minimumPhaseButton.setToggleState (p.isImpulseResponseMinimumPhase(), juce::dontSendNotification);
+    minimumPhaseButton.onClick = [this] { processor.setImpulseResponseMinimumPhase (minimumPhaseButton.getToggleState()); };
+
+    addAndMakeVisible (wallsButton);
+    addAndMakeVisible (modeBox);
+    addAndMakeVisible (loadIrButton);
+    addAndMakeVisible (minimumPhaseButton);
+    addAndMakeVisible (loadMorphIrButton);
+    addAndMakeVisible (morphSlider);
+}
+
+void PluginEditor::chooseImpulseResponse (bool forMorph)
+{
+    irChooser = std::make_unique<juce::FileChooser> (forMorph ? "Load morph impulse response" : "Load impulse response",
+                                                     forMorph ? processor.getMorphImpulseResponseFile() : processor.getImpulseResponseFile(),
+                                                     "*.wav;*.aif;*.aiff;*.flac");
+
+    irChooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                            [this, forMorph] (const juce::FileChooser& chooser)
+                            {
+                                if (const auto file = chooser.getResult(); file.existsAsFile())
+                                {
+                                    if (forMorph)
+                                        processor.loadMorphImpulseResponse (file);
+                                    else
+                                        processor.loadImpulseResponse (file);
+
+                                    updateLoadIrButtons();
+                                }
+                            });
+}
+
+void PluginEditor::showMorphIrMenu()
+{
+    if (! processor.getMorphImpulseResponseFile().existsAsFile())
+    {
+        chooseImpulseResponse (true);
+        return;
+    }
+
+    juce::PopupMenu menu;
+    menu.addItem ("Choose...", [this] { chooseImpulseResponse (true); });
+    menu.addItem ("Clear", [this]
+                  {
+                      processor.loadMorphImpulseResponse ({});
+                      updateLoadIrButtons();
+                  });
+
+    menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (loadMorphIrButton));
+}
+
+void PluginEditor::showWallsMenu()
+{
+    juce::PopupMenu menu;
+
+    for (auto* paramID : { ParamIDs::leftWall, ParamIDs::rightWall, ParamIDs::frontWall,
+                           ParamIDs::backWall, ParamIDs::floor,     ParamIDs::ceiling })
+    {
+        auto* parameter = dynamic_cast<juce::AudioParameterChoice*> (processor.getPluginState().getParameter (paramID));
+
+        if (parameter == nullptr)
+            continue;
+
+        juce::PopupMenu materials;
+
+        for (int i = 0; i < parameter->choices.size(); ++i)
+            materials.addItem (parameter->choices[i], true, i == parameter->getIndex(), [parameter, i]
+                               {
+                                   parameter->setValueNotifyingHost (parameter->convertTo0to1 (static_cast<float> (i)));
+                               });
+
+        const auto name = parameter->getName (64);
+        menu.addSubMenu (name.substring (0, 1).toUpperCase() + name.substring (1), materials);
+    }
+
+    menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (wallsButton));
+}
+
+void PluginEditor::updateLoadIrButtons()
+{
+    const auto file = processor.getImpulseResponseFile();
+    loadIrButton.setTooltip (file.getFullPathName());
+    loadIrButton.setButtonText (file.existsAsFile() ? file.getFileNameWithoutExtension() : "Load IR");
+
+    const auto morphFile = processor.getMorphImpulseResponseFile();
+    loadMorphIrButton.setTooltip (morphFile.getFullPathName());
+    loadMorphIrButton.setButtonText (morphFile.existsAsFile() ? morphFile.getFileNameWithoutExtension() : "Morph IR");
 }
 
 void PluginEditor::paint (juce::Graphics& g) 
@@ -85,8 +199,10 @@ void PluginEditor::resized()
     auto bounds = getLocalBounds();
     
     // Make analyzer taller
-    const int analyzerHeight = 300;  // Αυξήσαμε το ύψος από το default
-    processor.getAnalyzer().setBounds(bounds.removeFromTop(analyzerHeight));
+    const int analyzerHeight = 190;
+    const int waveformHeight = 80;
+    analyzer.setBounds(bounds.removeFromTop(analyzerHeight));
+    waveformView.setBounds (bounds.removeFromTop (waveformHeight));
     
     const auto factor = static_cast<float> (getWidth()) / defaultWidth;
     editorContent.setTransform (juce::AffineTransform::scale (factor));
@@ -109,6 +225,23 @@ void PluginEditor::resized()
     // Position the editor content (knobs) below the visualizer with spacing
     editorContent.setBounds(0, visualizerHeight + spacing, getWidth(), contentHeight);
 
+    // Walls, mode and impulse response in the free strip above the knobs
+    const int wallsButtonWidth = 80;
+    const int modeBoxWidth = 120;
+    const int loadIrButtonWidth = 110;
+    const int minimumPhaseButtonWidth = 90;
+    const int controlHeight = 24;
+    const int controlY = visualizerHeight + spacing + 10;
+    minimumPhaseButton.setBounds (getWidth() - minimumPhaseButtonWidth - 10, controlY, minimumPhaseButtonWidth, controlHeight);
+    loadIrButton.setBounds (minimumPhaseButton.getX() - loadIrButtonWidth - 10, controlY, loadIrButtonWidth, controlHeight);
+    modeBox.setBounds (loadIrButton.getX() - modeBoxWidth - 10, controlY, modeBoxWidth, controlHeight);
+    wallsButton.setBounds (modeBox.getX() - wallsButtonWidth - 10, controlY, wallsButtonWidth, controlHeight);
+
+    // Morph impulse response and position on a second row below
+    const int morphRowY = controlY + controlHeight + 4;
+    loadMorphIrButton.setBounds (modeBox.getX(), morphRowY, modeBoxWidth, controlHeight);
+    morphSlider.setBounds (loadIrButton.getX(), morphRowY, minimumPhaseButton.getRight() - loadIrButton.getX(), controlHeight);
+
     // Set the bounds of the text boxes and labels
     const int labelWidth = 80;
     const int textBoxHeight = 30;
@@ -140,21 +273,30 @@ void PluginEditor::textEditorTextChanged (juce::TextEditor& editor)
         editorContent.getDampDial().setParameterUpdatesEnabled(false);
         processor.damp->setValueNotifyingHost (editor.getText().getFloatValue() / 100.0f);
         editorContent.getDampDial().setParameterUpdatesEnabled(true);
+        setRoomDimension (ParamIDs::roomHeight, editor.getText().getFloatValue());
     }
     else if (&editor == &textBox2)
     {
         editorContent.getSizeDial().setParameterUpdatesEnabled(false);
         processor.size->setValueNotifyingHost (editor.getText().getFloatValue() / 100.0f);
         editorContent.getSizeDial().setParameterUpdatesEnabled(true);
+        setRoomDimension (ParamIDs::roomLength, editor.getText().getFloatValue());
     }
     else if (&editor == &textBox3)
     {
         editorContent.getWidthDial().setParameterUpdatesEnabled(false);
         processor.width->setValueNotifyingHost (editor.getText().getFloatValue() / 100.0f);
         editorContent.getWidthDial().setParameterUpdatesEnabled(true);
+        setRoomDimension (ParamIDs::roomWidth, editor.getText().getFloatValue());
     }
 }
 
+void PluginEditor::setRoomDimension (const char* paramID, float metres)
+{
+    if (auto* parameter = processor.getPluginState().getParameter (paramID))
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (metres));
+}
+
 bool PluginEditor::keyPressed (const juce::KeyPress& k)
 {
     if (k.isKeyCode ('Z') && k.getModifiers().isCommandDown())
@@ -172,9 +314,6 @@ bool PluginEditor::keyPressed (const juce::KeyPress& k)
 
 PluginEditor::~PluginEditor()
 {
-    // First, stop any processing
-    processor.suspendProcessing(true);
-    
     // Remove listeners before destruction
     textBox1.removeListener(this);
     textBox2.removeListener(this);
@@ -186,9 +325,13 @@ PluginEditor::~PluginEditor()
     editorContent.getWidthDial().setLookAndFeel(nullptr);
     
     // Remove child components in reverse order of addition
-    removeChildComponent(&processor.getAnalyzer());
+    removeChildComponent(&morphSlider);
+    removeChildComponent(&loadMorphIrButton);
+    removeChildComponent(&minimumPhaseButton);
+    removeChildComponent(&loadIrButton);
+    removeChildComponent(&modeBox);
+    removeChildComponent(&wallsButton);
+    removeChildComponent(&waveformView);
+    removeChildComponent(&analyzer);
     removeChildComponent(&editorContent);
-    
-    // Resume processing
-    processor.suspendProcessing(false);
 }
\ No newline at end of file
@@ -2,7 +2,10 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include "PluginProcessor.h"
+#include "ui/CustomAudioVisualiser.h"
 #include "ui/EditorContent.h"
+#include "ui/FrameScheduler.h"
+#include "ui/SpectrumAnalyzer.h"
 #include "ui/MyColours.h"
 #include "ui/NumericInputFilter.h"
 
@@ -20,17 +23,37 @@ public:
 private:
     void textEditorTextChanged (juce::TextEditor&) override;
 
+    // The text boxes also set the room the Room mode synthesises
+    void setRoomDimension (const char* paramID, float metres);
+    void chooseImpulseResponse (bool forMorph);
+    void showMorphIrMenu();
+    void showWallsMenu();
+    void updateLoadIrButtons();
+
     static constexpr int defaultWidth = 600;
     static constexpr int defaultHeight = 500;
 
     PluginProcessor& processor;
     juce::UndoManager& undoManager;
+    FrameScheduler frameScheduler;
     EditorContent editorContent;
+    SpectrumAnalyzer analyzer;
+    CustomAudioVisualiser waveformView;
 
     juce::TextEditor textBox1, textBox2, textBox3;
     juce::Label label1, label2, label3;
     juce::Label unitLabel1, unitLabel2, unitLabel3;
     NumericInputFilter numericInputFilter;
 
+    juce::ComboBox modeBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> modeAttachment;
+    juce::TextButton wallsButton { "Walls" };
+    juce::TextButton loadIrButton { "Load IR" };
+    juce::ToggleButton minimumPhaseButton { "Min phase" };
+    juce::TextButton loadMorphIrButton { "Morph IR" };
+    juce::Slider morphSlider { juce::Slider::LinearHorizontal, juce::Slider::TextBoxRight };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> morphAttachment;
+    std::unique_ptr<juce::FileChooser> irChooser;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
 };
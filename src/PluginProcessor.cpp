@@ -6,6 +6,35 @@
 #define JucePlugin_Name "3D Reverb"
 #endif
 
+#ifndef JucePlugin_VersionString
+#define JucePlugin_VersionString "1.0.0"
+#endif
+
+// The parameters updateReverbParams() reads
+static constexpr const char* reverbParamIDs[] { ParamIDs::size,   ParamIDs::damp,     ParamIDs::width, ParamIDs::mix,
+                                                ParamIDs::freeze, ParamIDs::tailRate, ParamIDs::mode,  ParamIDs::morph,
+                                                ParamIDs::reflections };
+
+// The material of each wall, in RoomModel::Wall order
+static constexpr const char* wallParamIDs[] { ParamIDs::leftWall, ParamIDs::rightWall, ParamIDs::frontWall,
+                                              ParamIDs::backWall, ParamIDs::floor,     ParamIDs::ceiling };
+static constexpr const char* wallNames[] { "left wall", "right wall", "front wall", "back wall", "floor", "ceiling" };
+
+// The parameters the Room mode's impulse response is synthesised from
+static constexpr const char* roomParamIDs[] { ParamIDs::roomWidth, ParamIDs::roomLength, ParamIDs::roomHeight,
+                                              ParamIDs::leftWall,  ParamIDs::rightWall,  ParamIDs::frontWall,
+                                              ParamIDs::backWall,  ParamIDs::floor,      ParamIDs::ceiling,
+                                              ParamIDs::mode };
+
+// The parameters the algorithmic reverb's decay filters are designed from
+static constexpr const char* decayParamIDs[] { ParamIDs::bandDecay,    ParamIDs::lowDecay,     ParamIDs::midDecay,
+                                               ParamIDs::highDecay,    ParamIDs::lowCrossover, ParamIDs::highCrossover };
+
+// State properties holding the impulse response file paths and preparation
+static const juce::Identifier impulseResponseProperty { "impulseResponse" };
+static const juce::Identifier impulseResponseMinimumPhaseProperty { "impulseResponseMinimumPhase" };
+static const juce::Identifier morphImpulseResponseProperty { "morphImpulseResponse" };
+
 static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
 {
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
@@ -52,6 +81,100 @@ static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout
     layout.add (std::make_unique<juce::AudioParameterBool> (
         juce::ParameterID { ParamIDs::freeze, 1 }, ParamIDs::freeze, false));
 
+    // Running the tail at a reduced rate clears it, so this is not automatable
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { ParamIDs::tailRate, 1 },
+                                                              "tail rate",
+                                                              juce::StringArray { "Full", "Reduced" },
+                                                              0,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+
+    // Convolution runs the loaded impulse response and Room one synthesised
+    // from the room's dimensions and walls, either falls back to the
+    // algorithmic reverb while it has none
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { ParamIDs::mode, 1 },
+                                                              ParamIDs::mode,
+                                                              juce::StringArray { "Algorithmic", "Convolution", "Room" },
+                                                              0));
+
+    // From the impulse response to the morph one, used while one is loaded
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { ParamIDs::morph, 1 },
+                                                             ParamIDs::morph,
+                                                             juce::NormalisableRange { 0.0f, 100.0f, 0.01f, 1.0f },
+                                                             0.0f,
+                                                             percentageAttributes));
+
+    // Every change synthesises a new impulse response, so these are not
+    // automatable
+    const auto metreAttributes = juce::AudioParameterFloatAttributes().withLabel ("m").withAutomatable (false);
+
+    for (auto [paramID, name, defaultValue] : { std::tuple { ParamIDs::roomWidth, "room width", 5.0f },
+                                                std::tuple { ParamIDs::roomLength, "room length", 8.0f },
+                                                std::tuple { ParamIDs::roomHeight, "room height", 3.0f } })
+    {
+        layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { paramID, 1 },
+                                                                 name,
+                                                                 juce::NormalisableRange { 1.0f, 100.0f, 0.01f, 1.0f },
+                                                                 defaultValue,
+                                                                 metreAttributes));
+    }
+
+    const auto materialAttributes = juce::AudioParameterChoiceAttributes().withAutomatable (false);
+    const RoomModel defaultRoom;
+
+    for (size_t wall = 0; wall < RoomModel::numWalls; ++wall)
+    {
+        layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { wallParamIDs[wall], 1 },
+                                                                  wallNames[wall],
+                                                                  RoomMaterials::getNames(),
+                                                                  defaultRoom.materials[wall],
+                                                                  materialAttributes));
+    }
+
+    // Decay times per band for the algorithmic reverb, in place of size and
+    // damp while band decay is on
+    layout.add (std::make_unique<juce::AudioParameterBool> (
+        juce::ParameterID { ParamIDs::bandDecay, 1 }, "band decay", false));
+
+    juce::NormalisableRange secondsRange { 0.1f, 30.0f, 0.01f };
+    secondsRange.setSkewForCentre (2.0f);
+    const auto secondsAttributes = juce::AudioParameterFloatAttributes().withLabel ("s");
+
+    for (auto [paramID, name, defaultValue] : { std::tuple { ParamIDs::lowDecay, "low decay", 2.0f },
+                                                std::tuple { ParamIDs::midDecay, "mid decay", 1.5f },
+                                                std::tuple { ParamIDs::highDecay, "high decay", 0.7f } })
+    {
+        layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { paramID, 1 },
+                                                                 name,
+                                                                 secondsRange,
+                                                                 defaultValue,
+                                                                 secondsAttributes));
+    }
+
+    const auto hertzAttributes = juce::AudioParameterFloatAttributes().withLabel ("Hz");
+    juce::NormalisableRange lowCrossoverRange { 50.0f, 1000.0f, 1.0f };
+    lowCrossoverRange.setSkewForCentre (250.0f);
+    juce::NormalisableRange highCrossoverRange { 1000.0f, 16000.0f, 1.0f };
+    highCrossoverRange.setSkewForCentre (4000.0f);
+
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { ParamIDs::lowCrossover, 1 },
+                                                             "low crossover",
+                                                             lowCrossoverRange,
+                                                             250.0f,
+                                                             hertzAttributes));
+
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { ParamIDs::highCrossover, 1 },
+                                                             "high crossover",
+                                                             highCrossoverRange,
+                                                             4000.0f,
+                                                             hertzAttributes));
+
+    // Velvet-noise early reflections ahead of the algorithmic tail
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { ParamIDs::reflections, 1 },
+                                                             ParamIDs::reflections,
+                                                             juce::NormalisableRange { 0.0f, 100.0f, 0.01f, 1.0f },
+                                                             0.0f,
+                                                             percentageAttributes));
+
     return layout;
 }
 
@@ -72,6 +195,34 @@ PluginProcessor::PluginProcessor()
     castParameter (ParamIDs::width, width);
     castParameter (ParamIDs::mix, mix);
     castParameter (ParamIDs::freeze, freeze);
+    castParameter (ParamIDs::tailRate, tailRate);
+    castParameter (ParamIDs::mode, mode);
+    castParameter (ParamIDs::morph, morph);
+    castParameter (ParamIDs::roomWidth, roomWidth);
+    castParameter (ParamIDs::roomLength, roomLength);
+    castParameter (ParamIDs::roomHeight, roomHeight);
+
+    for (size_t wall = 0; wall < RoomModel::numWalls; ++wall)
+        castParameter (wallParamIDs[wall], wallMaterials[wall]);
+
+    castParameter (ParamIDs::bandDecay, bandDecay);
+    castParameter (ParamIDs::lowDecay, lowDecay);
+    castParameter (ParamIDs::midDecay, midDecay);
+    castParameter (ParamIDs::highDecay, highDecay);
+    castParameter (ParamIDs::lowCrossover, lowCrossover);
+    castParameter (ParamIDs::highCrossover, highCrossover);
+    castParameter (ParamIDs::reflections, reflections);
+
+    for (auto* paramID : reverbParamIDs)
+        apvts.addParameterListener (paramID, this);
+
+    for (auto* paramID : roomParamIDs)
+        apvts.addParameterListener (paramID, this);
+
+    for (auto* paramID : decayParamIDs)
+        apvts.addParameterListener (paramID, this);
+
+    irCache->setDiskCache (IrDiskCache::getDefaultDirectory (JucePlugin_Name), JucePlugin_VersionString);
 
     // Initialize parameter change tracking
     lastSize = size->get() * 0.01f;
@@ -83,7 +234,16 @@ PluginProcessor::PluginProcessor()
 
 PluginProcessor::~PluginProcessor()
 {
-    // Destructor implementation
+    cancelPendingUpdate();
+
+    for (auto* paramID : reverbParamIDs)
+        apvts.removeParameterListener (paramID, this);
+
+    for (auto* paramID : roomParamIDs)
+        apvts.removeParameterListener (paramID, this);
+
+    for (auto* paramID : decayParamIDs)
+        apvts.removeParameterListener (paramID, this);
 }
 
 const juce::String PluginProcessor::getName() const { return JucePlugin_Name; }
@@ -140,13 +300,123 @@ void PluginProcessor::changeProgramName (int index, const juce::String& newName)
 
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec {};
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = static_cast<juce::uint32> (samplesPerBlock);
-    spec.numChannels = static_cast<juce::uint32> (getTotalNumOutputChannels());
+    juce::ignoreUnused (samplesPerBlock);
+
+    // Everything below re-indexes into storage allocated up front for
+    // ProcessingLimits, so this is bounded-time and does not allocate unless
+    // the bus layout is wider than any seen before. The reverb picks its
+    // network specialisation from the main bus layout
+    const auto numInputChannels = getMainBusNumInputChannels();
+    const auto numChannels = getMainBusNumOutputChannels();
+    jassert (ReverbEngine::isLayoutSupported (numInputChannels, numChannels));
+
+    reverb.prepare (sampleRate, numInputChannels, numChannels);
+    freezeLooper.prepare (sampleRate, numChannels);
+
+    dryGain.reset (sampleRate, 0.01);
+    wetGain.reset (sampleRate, 0.01);
+
+    updateReverbParams (true);
+    dryGain.setCurrentAndTargetValue (dryGain.getTargetValue());
+    wetGain.setCurrentAndTargetValue (wetGain.getTargetValue());
+    freezeLooper.setFrozen (lastFreeze);
+    analyzerFeed->setSampleRate (static_cast<float> (sampleRate));
+
+    dryHistory.setSampleRate (sampleRate);
+    wetHistory.setSampleRate (sampleRate);
+    dryHistory.reset();
+    wetHistory.reset();
+
+    // Bringing the impulse response to a new rate or layout loads and
+    // prepares it again in the background. Until then the previous one
+    // keeps playing, or the algorithmic reverb if its layout no longer fits.
+    // The multiband decay is redesigned for the new rate there too, and
+    // the tail follows the room size and damping meanwhile
+    convolution.prepare (sampleRate);
+    roomConvolution.prepare (sampleRate);
+    triggerAsyncUpdate();
+}
 
-    reverb.prepare (spec);
-    analyzer.setSampleRate(static_cast<float>(sampleRate));
+void PluginProcessor::loadImpulseResponse (const juce::File& file)
+{
+    apvts.state.setProperty (impulseResponseProperty, file.getFullPathName(), nullptr);
+    handleAsyncUpdate();
+}
+
+juce::File PluginProcessor::getImpulseResponseFile() const
+{
+    return juce::File (apvts.state.getProperty (impulseResponseProperty).toString());
+}
+
+void PluginProcessor::setImpulseResponseMinimumPhase (bool shouldBeMinimumPhase)
+{
+    apvts.state.setProperty (impulseResponseMinimumPhaseProperty, shouldBeMinimumPhase, nullptr);
+    handleAsyncUpdate();
+}
+
+bool PluginProcessor::isImpulseResponseMinimumPhase() const
+{
+    return apvts.state.getProperty (impulseResponseMinimumPhaseProperty, false);
+}
+
+void PluginProcessor::loadMorphImpulseResponse (const juce::File& file)
+{
+    apvts.state.setProperty (morphImpulseResponseProperty, file.getFullPathName(), nullptr);
+    handleAsyncUpdate();
+}
+
+juce::File PluginProcessor::getMorphImpulseResponseFile() const
+{
+    return juce::File (apvts.state.getProperty (morphImpulseResponseProperty).toString());
+}
+
+void PluginProcessor::handleAsyncUpdate()
+{
+    IrLoader::Request wanted { getImpulseResponseFile(),
+                               getSampleRate(),
+                               getMainBusNumInputChannels(),
+                               getMainBusNumOutputChannels(),
+                               {},
+                               getMorphImpulseResponseFile() };
+    wanted.preparation.minimumPhaseHead = isImpulseResponseMinimumPhase();
+
+    if (wanted.sampleRate > 0.0)
+    {
+        irLoader.request (wanted);
+        reverb.setMultibandDecay (getMultibandDecay(), wanted.sampleRate);
+    }
+
+    // Only synthesised while in use; the generator keeps the last few rooms,
+    // so switching back and forth stays cheap
+    if (wanted.sampleRate > 0.0 && mode->getIndex() == 2)
+        roomGenerator.request ({ getRoomModel(), wanted.sampleRate, wanted.numInputChannels, getChannelLayoutOfBus (false, 0) });
+}
+
+RoomModel PluginProcessor::getRoomModel() const
+{
+    RoomModel room;
+    room.width = roomWidth->get();
+    room.length = roomLength->get();
+    room.height = roomHeight->get();
+
+    for (size_t wall = 0; wall < RoomModel::numWalls; ++wall)
+        room.materials[wall] = wallMaterials[wall]->getIndex();
+
+    return room;
+}
+
+std::optional<MultibandDecay> PluginProcessor::getMultibandDecay() const
+{
+    if (! bandDecay->get())
+        return std::nullopt;
+
+    MultibandDecay decay;
+    decay.lowSeconds = lowDecay->get();
+    decay.midSeconds = midDecay->get();
+    decay.highSeconds = highDecay->get();
+    decay.lowCrossover = lowCrossover->get();
+    decay.highCrossover = highCrossover->get();
+    return decay;
 }
 
 void PluginProcessor::releaseResources()
@@ -157,18 +427,59 @@ void PluginProcessor::releaseResources()
 
 bool PluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // The layouts the reverb has a compile-time specialised network for
+    const juce::AudioChannelSet supportedSets[] { juce::AudioChannelSet::mono(),
+                                                  juce::AudioChannelSet::stereo(),
+                                                  juce::AudioChannelSet::quadraphonic(),
+                                                  juce::AudioChannelSet::create5point1(),
+                                                  juce::AudioChannelSet::create7point1point4() };
+
+    if (std::find (std::begin (supportedSets), std::end (supportedSets), layouts.getMainOutputChannelSet())
+        == std::end (supportedSets))
         return false;
 
+    // Mono in, stereo out runs a single shared comb bank
+    if (layouts.getMainInputChannelSet() == juce::AudioChannelSet::mono()
+        && layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo())
+        return true;
+
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
 
     return true;
 }
 
-void PluginProcessor::updateReverbParams()
+void PluginProcessor::parameterChanged (const juce::String& parameterID, float newValue)
 {
+    juce::ignoreUnused (newValue);
+    parametersChanged.store (true, std::memory_order_release);
+
+    const auto isIn = [&] (const auto& paramIDs)
+    {
+        return std::find_if (std::begin (paramIDs), std::end (paramIDs), [&] (auto* id) { return parameterID == id; })
+            != std::end (paramIDs);
+    };
+
+    if (isIn (roomParamIDs) || isIn (decayParamIDs))
+        triggerAsyncUpdate();
+}
+
+void PluginProcessor::updateReverbParams (bool forceUpdate)
+{
+    // The plain load keeps the common no-change case free of a
+    // read-modify-write. Cleared before reading, so a change that lands
+    // while reading is picked up on the next block
+    if (! parametersChanged.load (std::memory_order_relaxed) && ! forceUpdate)
+        return;
+
+    parametersChanged.exchange (false, std::memory_order_acq_rel);
+
+    // Bounded-time and allocation-free, the engine only re-indexes its lines
+    reverb.setTailRate (tailRate->getIndex() == 0 ? ReverbEngine::TailRate::full : ReverbEngine::TailRate::reduced);
+    convolutionInUse = mode->getIndex() == 1 ? &convolution : mode->getIndex() == 2 ? &roomConvolution : nullptr;
+    convolution.setMorphPosition (morph->get() * 0.01f);
+    reverb.setReflectionLevel (reflections->get() * 0.01f);
+
     const float currentSize = size->get() * 0.01f;
     const float currentDamp = damp->get() * 0.01f;
     const float currentWidth = width->get() * 0.01f;
@@ -176,19 +487,27 @@ void PluginProcessor::updateReverbParams()
     const bool currentFreeze = freeze->get();
 
     // Only update parameters if they've changed
-    if (currentSize != lastSize || currentDamp != lastDamp || 
-        currentWidth != lastWidth || currentMix != lastMix || 
-        currentFreeze != lastFreeze)
+    if (forceUpdate || ! juce::exactlyEqual (currentSize, lastSize) || ! juce::exactlyEqual (currentDamp, lastDamp)
+        || ! juce::exactlyEqual (currentWidth, lastWidth) || ! juce::exactlyEqual (currentMix, lastMix)
+        || currentFreeze != lastFreeze)
     {
         params.roomSize = currentSize;
         params.damping = currentDamp;
         params.width = currentWidth;
-        params.wetLevel = currentMix;
-        params.dryLevel = 1.0f - currentMix;
+        params.wetLevel = 1.0f;
+        params.dryLevel = 0.0f;
         params.freezeMode = currentFreeze;
 
         reverb.setParameters(params);
 
+        // Same gain staging juce::Reverb applies internally (dry x2, wet x3 on
+        // top of the unit wet level used above)
+        dryGain.setTargetValue ((1.0f - currentMix) * 2.0f);
+        wetGain.setTargetValue (currentMix);
+
+        if (currentFreeze != lastFreeze)
+            freezeLooper.setFrozen (currentFreeze);
+
         // Update last values
         lastSize = currentSize;
         lastDamp = currentDamp;
@@ -205,20 +524,87 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Midi
 
     updateReverbParams();
 
-    // Process reverb with proper buffer handling
-    juce::dsp::AudioBlock<float> block (buffer);
-    juce::dsp::ProcessContextReplacing ctx (block);
-    
-    // Ensure buffer is properly sized
-    if (block.getNumSamples() > 0)
+    const auto numInputChannels = juce::jmin (getTotalNumInputChannels(), buffer.getNumChannels());
+
+    // Refers to the host's channel data, no allocation
+    dryHistory.push (juce::AudioBuffer<float> (buffer.getArrayOfWritePointers(), numInputChannels, buffer.getNumSamples()));
+
+    // With a mono input on a stereo output the dry signal is the input on
+    // both sides, the reverb itself only reads the first channel
+    if (! isSendMode())
+        for (int ch = numInputChannels; ch > 0 && ch < buffer.getNumChannels(); ++ch)
+            buffer.copyFrom (ch, 0, buffer, 0, 0, buffer.getNumSamples());
+
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), dryBuffer.getNumChannels());
+
+    for (int start = 0; numChannels > 0 && start < buffer.getNumSamples(); start += ProcessingLimits::maxBlockSize)
     {
-        reverb.process (ctx);
+        const auto length = juce::jmin (ProcessingLimits::maxBlockSize, buffer.getNumSamples() - start);
+
+        // Refers to the host's channel data, no allocation
+        juce::AudioBuffer<float> chunk (buffer.getArrayOfWritePointers(), numChannels, start, length);
+        processChunk (chunk);
     }
 
-    // Push audio data to analyzer only if we have valid data
+    wetHistory.push (buffer);
+
+    // Push audio data to analyzer only if we have valid data. In send mode
+    // this is the wet signal as the reverb wrote it
     if (buffer.getNumChannels() > 0 && buffer.getNumSamples() > 0)
     {
-        analyzer.pushBuffer(buffer.getReadPointer(0), buffer.getNumSamples());
+        analyzerFeed->push (buffer.getReadPointer (0), buffer.getNumSamples());
+    }
+}
+
+bool PluginProcessor::isSendMode() const noexcept
+{
+    // 100 % mix, and done ramping there
+    return juce::approximatelyEqual (dryGain.getTargetValue(), 0.0f)
+        && juce::approximatelyEqual (wetGain.getTargetValue(), 1.0f)
+        && ! dryGain.isSmoothing() && ! wetGain.isSmoothing();
+}
+
+void PluginProcessor::processChunk (juce::AudioBuffer<float>& buffer)
+{
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = buffer.getNumChannels();
+
+    // On an FX return the reverb's output is the plug-in's output, so there
+    // is no dry signal to keep or mix back in
+    const auto sendMode = isSendMode();
+
+    if (! sendMode)
+        for (int ch = 0; ch < numChannels; ++ch)
+            dryBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
+    // While the freeze loop is playing on its own the reverb is not run at all
+    if (numSamples > 0 && freezeLooper.needsReverb())
+        if (convolutionInUse == nullptr || ! convolutionInUse->process (buffer.getArrayOfWritePointers(), numChannels, numSamples))
+            reverb.process (buffer, numSamples);
+
+    freezeLooper.process (buffer, numSamples);
+
+    if (sendMode)
+        return;
+
+    if (dryGain.isSmoothing() || wetGain.isSmoothing())
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto dry = dryGain.getNextValue();
+            const auto wet = wetGain.getNextValue();
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                buffer.setSample (ch, i, buffer.getSample (ch, i) * wet + dryBuffer.getSample (ch, i) * dry);
+        }
+    }
+    else
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            buffer.applyGain (ch, 0, numSamples, wetGain.getTargetValue());
+            buffer.addFrom (ch, 0, dryBuffer, ch, 0, numSamples, dryGain.getTargetValue());
+        }
     }
 }
 
@@ -238,7 +624,10 @@ void PluginProcessor::getStateInformation (juce::MemoryBlock& destData)
 void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     if (const auto tree = juce::ValueTree::readFromData (data, static_cast<size_t> (sizeInBytes)); tree.isValid())
+    {
         apvts.replaceState (tree);
+        triggerAsyncUpdate();
+    }
 }
 
 // This creates new instances of the plugin..
@@ -3,9 +3,18 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_utils/juce_audio_utils.h>
-#include "ui/SpectrumAnalyzer.h"
-
-class PluginProcessor final : public juce::AudioProcessor
+#include "dsp/ConvolutionEngine.h"
+#include "dsp/FreezeLooper.h"
+#include "dsp/IrCache.h"
+#include "dsp/IrLoader.h"
+#include "dsp/ReverbEngine.h"
+#include "dsp/RoomIrGenerator.h"
+#include "ui/AnalyzerFeed.h"
+#include "ui/MinMaxPyramid.h"
+
+class PluginProcessor final : public juce::AudioProcessor,
+                              private juce::AudioProcessorValueTreeState::Listener,
+                              private juce::AsyncUpdater
 {
 public:
     PluginProcessor();
@@ -38,7 +47,22 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     juce::AudioProcessorValueTreeState& getPluginState() { return apvts; }
-    SpectrumAnalyzer& getAnalyzer() { return analyzer; }
+    AnalyzerFeed::Ptr getAnalyzerFeed() const { return analyzerFeed; }
+    const MinMaxPyramid& getDryHistory() const { return dryHistory; }
+    const MinMaxPyramid& getWetHistory() const { return wetHistory; }
+
+    // Message thread. The file and its preparation are stored with the
+    // plug-in state and used by the Convolution mode. Loading happens in the
+    // background, the previous impulse response plays until it is done
+    void loadImpulseResponse (const juce::File& file);
+    juce::File getImpulseResponseFile() const;
+    void setImpulseResponseMinimumPhase (bool shouldBeMinimumPhase);
+    bool isImpulseResponseMinimumPhase() const;
+
+    // Second impulse response the morph parameter moves towards, in the
+    // frequency domain. An empty file plays the first one alone
+    void loadMorphImpulseResponse (const juce::File& file);
+    juce::File getMorphImpulseResponseFile() const;
 
     // Make public
     juce::AudioParameterFloat* damp { nullptr };
@@ -57,14 +81,73 @@ private:
 
     juce::AudioParameterFloat* mix { nullptr };
     juce::AudioParameterBool* freeze { nullptr };
-
-    void updateReverbParams();
-
-    juce::dsp::Reverb::Parameters params;
-    juce::dsp::Reverb reverb;
+    juce::AudioParameterChoice* tailRate { nullptr };
+    juce::AudioParameterChoice* mode { nullptr };
+    juce::AudioParameterFloat* morph { nullptr };
+    juce::AudioParameterFloat* roomWidth { nullptr };
+    juce::AudioParameterFloat* roomLength { nullptr };
+    juce::AudioParameterFloat* roomHeight { nullptr };
+    std::array<juce::AudioParameterChoice*, RoomModel::numWalls> wallMaterials {};
+    juce::AudioParameterBool* bandDecay { nullptr };
+    juce::AudioParameterFloat* lowDecay { nullptr };
+    juce::AudioParameterFloat* midDecay { nullptr };
+    juce::AudioParameterFloat* highDecay { nullptr };
+    juce::AudioParameterFloat* lowCrossover { nullptr };
+    juce::AudioParameterFloat* highCrossover { nullptr };
+    juce::AudioParameterFloat* reflections { nullptr };
+
+    // Set from any thread when a parameter moves, so blocks without a change
+    // skip reading and comparing every parameter
+    std::atomic<bool> parametersChanged { true };
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+
+    // Asks for the impulse response to be reloaded if the file, its
+    // preparation, the rate or the layout changed, and in the Room mode for
+    // the room to be synthesised again if it changed. Hands the
+    // reverb its decay filters too
+    void handleAsyncUpdate() override;
+
+    // The room the Room mode synthesises, from the current parameters
+    RoomModel getRoomModel() const;
+
+    // The decay per band for the algorithmic reverb, nullopt while it follows
+    // size and damp
+    std::optional<MultibandDecay> getMultibandDecay() const;
+
+    void updateReverbParams (bool forceUpdate = false);
+    void processChunk (juce::AudioBuffer<float>& chunk);
+
+    // True once mix has settled at 100 %: the reverb writes straight into the
+    // host buffer and the dry path is skipped
+    bool isSendMode() const noexcept;
+
+    ReverbEngine::Parameters params;
+    ReverbEngine reverb;
+    FreezeLooper freezeLooper;
+
+    // Declared before the engine so the cache outlives the partitions the
+    // engine's convolvers hold
+    juce::SharedResourcePointer<IrCache> irCache;
+    ConvolutionEngine convolution;
+    ConvolutionEngine roomConvolution;
+    ConvolutionEngine* convolutionInUse { nullptr }; // audio thread, nullptr in the Algorithmic mode
+
+    // Declared after what they feed, so their threads stop first
+    IrLoader irLoader { *irCache, convolution };
+    RoomIrGenerator roomGenerator { *irCache, roomConvolution };
+
+    // The reverb renders wet only; the dry/wet mix happens here so that the
+    // freeze loop can stand in for the reverb output. Sized once for the
+    // processing limits; longer host blocks are split into chunks
+    juce::AudioBuffer<float> dryBuffer { ProcessingLimits::maxChannels, ProcessingLimits::maxBlockSize };
+    juce::SmoothedValue<float> dryGain;
+    juce::SmoothedValue<float> wetGain;
 
     juce::UndoManager undoManager;
-    SpectrumAnalyzer analyzer;
+    AnalyzerFeed::Ptr analyzerFeed { new AnalyzerFeed() };
+    MinMaxPyramid dryHistory;
+    MinMaxPyramid wetHistory;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
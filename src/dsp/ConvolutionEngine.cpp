@@ -0,0 +1,149 @@
+#include "ConvolutionEngine.h"
+
+ConvolutionEngine::ConvolutionEngine()
+{
+    for (int ch = 0; ch < ProcessingLimits::maxChannels; ++ch)
+        fadePointers[static_cast<size_t> (ch)] = fadeBuffer.getWritePointer (ch);
+}
+
+ConvolutionEngine::~ConvolutionEngine() { cancelPendingUpdate(); }
+
+void ConvolutionEngine::prepare (double sampleRate) noexcept
+{
+    fadeLength = juce::roundToInt (fadeSeconds * sampleRate);
+    reset();
+}
+
+void ConvolutionEngine::setImpulseResponse (std::shared_ptr<const IrPartitions> impulseResponse,
+                                            int numInputChannels,
+                                            int numOutputChannels)
+{
+    queue (impulseResponse != nullptr
+               ? std::make_unique<PartitionedConvolver> (std::move (impulseResponse), numInputChannels, numOutputChannels)
+               : nullptr);
+}
+
+void ConvolutionEngine::setImpulseResponse (std::shared_ptr<IrMorph> morph, int numInputChannels, int numOutputChannels)
+{
+    queue (morph != nullptr
+               ? std::make_unique<PartitionedConvolver> (std::move (morph), numInputChannels, numOutputChannels)
+               : nullptr);
+}
+
+void ConvolutionEngine::queue (std::unique_ptr<PartitionedConvolver> convolver)
+{
+    if (convolver != nullptr)
+        convolver->reset();
+
+    {
+        const juce::SpinLock::ScopedLockType sl (swapLock);
+        std::swap (pending, convolver);
+        hasPending = true;
+    }
+
+    // Whatever was still pending is replaced unheard, and freed here
+    convolver.reset();
+    handleAsyncUpdate();
+}
+
+void ConvolutionEngine::reset() noexcept
+{
+    if (active != nullptr)
+        active->reset();
+
+    // A fade in progress would carry the old state over
+    fadePosition = fadeLength;
+}
+
+bool ConvolutionEngine::process (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    swapPending();
+
+    if (active == nullptr || numChannels < active->getNumOutputChannels())
+        return false;
+
+    active->setMorphPosition (getMorphPosition());
+
+    if (fading != nullptr && fadePosition < fadeLength)
+        processFade (channels, numSamples);
+    else
+        active->process (channels, numSamples);
+
+    return true;
+}
+
+void ConvolutionEngine::swapPending() noexcept
+{
+    const juce::SpinLock::ScopedTryLockType sl (swapLock);
+
+    if (! sl.isLocked())
+        return;
+
+    // The previous convolver has to be freed before the next one retires
+    if (fading != nullptr && fadePosition >= fadeLength && retired == nullptr)
+    {
+        retired = std::move (fading);
+        triggerAsyncUpdate();
+    }
+
+    if (! hasPending || fading != nullptr || retired != nullptr)
+        return;
+
+    // Loading or unloading switches from or to the algorithmic reverb, and
+    // a new layout can't share the input, so only like replaces like smoothly
+    const auto canFade = active != nullptr && pending != nullptr && fadeLength > 0
+                      && active->getNumInputChannels() == pending->getNumInputChannels()
+                      && active->getNumOutputChannels() == pending->getNumOutputChannels();
+
+    if (canFade)
+    {
+        fading = std::move (active);
+        fadePosition = 0;
+    }
+    else
+    {
+        retired = std::move (active);
+        triggerAsyncUpdate();
+    }
+
+    active = std::move (pending);
+    hasPending = false;
+}
+
+void ConvolutionEngine::processFade (float* const* channels, int numSamples) noexcept
+{
+    const auto numOutputs = active->getNumOutputChannels();
+
+    for (int ch = 0; ch < numOutputs; ++ch)
+        std::copy_n (channels[ch], numSamples, fadePointers[static_cast<size_t> (ch)]);
+
+    fading->process (fadePointers.data(), numSamples);
+    active->process (channels, numSamples);
+
+    // Both convolve the same input, so a linear fade keeps the level
+    const auto step = 1.0f / static_cast<float> (fadeLength);
+
+    for (int ch = 0; ch < numOutputs; ++ch)
+    {
+        auto* out = channels[ch];
+        const auto* old = fadePointers[static_cast<size_t> (ch)];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto gain = juce::jmin (1.0f, static_cast<float> (fadePosition + i + 1) * step);
+            out[i] = old[i] + gain * (out[i] - old[i]);
+        }
+    }
+
+    fadePosition += numSamples;
+}
+
+void ConvolutionEngine::handleAsyncUpdate()
+{
+    std::unique_ptr<PartitionedConvolver> toFree;
+
+    {
+        const juce::SpinLock::ScopedLockType sl (swapLock);
+        std::swap (toFree, retired);
+    }
+}
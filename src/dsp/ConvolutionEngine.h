@@ -0,0 +1,64 @@
+#pragma once
+
+#include "IrPartitions.h"
+#include "PartitionedConvolver.h"
+#include "ProcessingLimits.h"
+#include <juce_events/juce_events.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+// Hands convolvers built off the audio thread to it. A new convolver waits in
+// a pending slot until the next process() call picks it up; the one it
+// replaces keeps running and is crossfaded out over fadeSeconds when both
+// serve the same layout, then parked and freed back on the message thread,
+// so the audio thread never allocates or frees. The audio thread only ever
+// try-locks, a swap that would have to wait is simply retried next block.
+class ConvolutionEngine final : private juce::AsyncUpdater
+{
+public:
+    static constexpr double fadeSeconds { 0.05 };
+
+    ConvolutionEngine();
+    ~ConvolutionEngine() override;
+
+    // Not concurrently with process()
+    void prepare (double sampleRate) noexcept;
+
+    // Any thread but the audio thread. Builds the convolution state for the
+    // layout and queues it; nullptr unloads
+    void setImpulseResponse (std::shared_ptr<const IrPartitions> impulseResponse, int numInputChannels, int numOutputChannels);
+    void setImpulseResponse (std::shared_ptr<IrMorph> morph, int numInputChannels, int numOutputChannels);
+
+    // Any thread. Where a morphing impulse response stands, including ones
+    // loaded later; ignored by plain ones
+    void setMorphPosition (float newPosition) noexcept { morphPosition.store (newPosition, std::memory_order_relaxed); }
+    float getMorphPosition() const noexcept { return morphPosition.load (std::memory_order_relaxed); }
+
+    // Not concurrently with process()
+    void reset() noexcept;
+
+    // In place. Returns false and leaves the channels untouched while there
+    // is no impulse response
+    bool process (float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    void handleAsyncUpdate() override;
+
+    void queue (std::unique_ptr<PartitionedConvolver> convolver);
+    void swapPending() noexcept;
+    void processFade (float* const* channels, int numSamples) noexcept;
+
+    juce::SpinLock swapLock;
+    std::unique_ptr<PartitionedConvolver> pending, active, fading, retired;
+    bool hasPending { false }; // guarded by swapLock, pending may be an unload
+
+    // The outgoing convolver renders into fadeBuffer from a copy of the input
+    juce::AudioBuffer<float> fadeBuffer { ProcessingLimits::maxChannels, ProcessingLimits::maxBlockSize };
+    std::array<float*, ProcessingLimits::maxChannels> fadePointers {};
+    int fadeLength { 0 };
+    int fadePosition { 0 };
+    std::atomic<float> morphPosition { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionEngine)
+};
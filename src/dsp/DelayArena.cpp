@@ -0,0 +1,62 @@
+#include "DelayArena.h"
+
+#if REVERB_LOCK_DELAY_MEMORY && (JUCE_MAC || JUCE_LINUX || JUCE_BSD)
+    #include <sys/mman.h>
+#endif
+
+DelayArena::~DelayArena() { release(); }
+
+void DelayArena::allocate (const std::vector<size_t>& lineSizes)
+{
+    release();
+
+    // Lay the lines out back to back, rounding each start up to a cache line
+    // and then on to the next set colour, so consecutive lines begin in
+    // different cache sets even when their lengths are multiples of 4 KiB
+    offsets.resize (lineSizes.size());
+    size_t offset = 0;
+
+    for (size_t i = 0; i < lineSizes.size(); ++i)
+    {
+        offset = (offset + cacheLineSize - 1) / cacheLineSize * cacheLineSize;
+
+        const auto wantedSet = (i * 5) % numCacheSets;
+        const auto currentSet = (offset / cacheLineSize) % numCacheSets;
+        offset += ((wantedSet + numCacheSets - currentSet) % numCacheSets) * cacheLineSize;
+
+        offsets[i] = offset;
+        offset += lineSizes[i];
+    }
+
+    sizeInBytes = offset;
+    storage.allocate (sizeInBytes + cacheLineSize, false);
+
+    const auto address = reinterpret_cast<uintptr_t> (storage.get());
+    base = storage.get() + (cacheLineSize - address % cacheLineSize) % cacheLineSize;
+
+    // Writing every byte here both clears the lines and prefaults every page
+    clear();
+
+#if REVERB_LOCK_DELAY_MEMORY && (JUCE_MAC || JUCE_LINUX || JUCE_BSD)
+    locked = mlock (base, sizeInBytes) == 0;
+#endif
+}
+
+void DelayArena::clear() noexcept
+{
+    if (base != nullptr)
+        std::memset (base, 0, sizeInBytes);
+}
+
+void DelayArena::release()
+{
+#if REVERB_LOCK_DELAY_MEMORY && (JUCE_MAC || JUCE_LINUX || JUCE_BSD)
+    if (locked)
+        munlock (base, sizeInBytes);
+#endif
+
+    locked = false;
+    storage.free();
+    base = nullptr;
+    sizeInBytes = 0;
+}
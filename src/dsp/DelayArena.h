@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// Set to 1 to additionally pin the arena in physical memory (POSIX only)
+#ifndef REVERB_LOCK_DELAY_MEMORY
+    #define REVERB_LOCK_DELAY_MEMORY 0
+#endif
+
+// One contiguous, cache-line aligned block holding every delay line of a
+// reverb. Lines start on their own cache line and are staggered across cache
+// sets so the lines read in the same sample don't evict each other. All pages
+// are touched when the arena is allocated, so the audio thread never takes a
+// first-touch page fault on delay memory.
+class DelayArena final
+{
+public:
+    static constexpr size_t cacheLineSize { 64 };
+
+    DelayArena() = default;
+    ~DelayArena();
+
+    // Not real-time safe. Line sizes are in bytes
+    void allocate (const std::vector<size_t>& lineSizes);
+
+    void clear() noexcept;
+
+    template <typename SampleType>
+    SampleType* getLine (int index) const noexcept
+    {
+        return reinterpret_cast<SampleType*> (base + offsets[static_cast<size_t> (index)]);
+    }
+
+    int getNumLines() const noexcept { return static_cast<int> (offsets.size()); }
+    size_t getSizeInBytes() const noexcept { return sizeInBytes; }
+
+private:
+    void release();
+
+    // Number of distinct L1 sets a line start can be coloured onto
+    static constexpr size_t numCacheSets { 64 };
+
+    juce::HeapBlock<char> storage;
+    char* base { nullptr };
+    std::vector<size_t> offsets;
+    size_t sizeInBytes {};
+    bool locked { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayArena)
+};
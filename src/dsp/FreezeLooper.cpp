@@ -0,0 +1,132 @@
+#include "FreezeLooper.h"
+
+FreezeLooper::FreezeLooper() { allocate (ProcessingLimits::maxSampleRate, ProcessingLimits::preallocatedChannels); }
+
+void FreezeLooper::allocate (double capacitySampleRate, int numChannels)
+{
+    capture.setSize (numChannels,
+                     juce::roundToInt (loopSeconds * capacitySampleRate) + juce::roundToInt (fadeSeconds * capacitySampleRate),
+                     false,
+                     false,
+                     true);
+    fadeCurve.resize (static_cast<size_t> (juce::roundToInt (fadeSeconds * capacitySampleRate)));
+}
+
+void FreezeLooper::prepare (double sampleRate, int numChannels)
+{
+    loopLength = juce::roundToInt (loopSeconds * sampleRate);
+    fadeLength = juce::jmax (1, juce::roundToInt (fadeSeconds * sampleRate));
+    captureLength = loopLength + fadeLength;
+
+    if (captureLength > capture.getNumSamples() || numChannels > capture.getNumChannels()
+        || fadeLength > static_cast<int> (fadeCurve.size()))
+        allocate (sampleRate, juce::jmax (numChannels, capture.getNumChannels()));
+
+    // Equal-power curve, the loop ends and the live reverb are uncorrelated
+    for (int i = 0; i < fadeLength; ++i)
+        fadeCurve[static_cast<size_t> (i)] = std::sin (juce::MathConstants<float>::halfPi * static_cast<float> (i + 1)
+                                                       / static_cast<float> (fadeLength));
+
+    reset();
+}
+
+void FreezeLooper::reset()
+{
+    state = State::idle;
+    captured = 0;
+    loopPosition = 0;
+    fadePosition = 0;
+}
+
+void FreezeLooper::setFrozen (bool shouldBeFrozen)
+{
+    if (shouldBeFrozen)
+    {
+        if (state == State::idle)
+        {
+            state = State::capturing;
+            captured = 0;
+        }
+        else if (state == State::fadingOut)
+        {
+            // The previous loop is still valid, fade it back in from where the
+            // fade out got to
+            state = State::fadingIn;
+            fadePosition = fadeLength - 1 - fadePosition;
+        }
+    }
+    else
+    {
+        if (state == State::capturing)
+        {
+            state = State::idle;
+        }
+        else if (state == State::fadingIn || state == State::looping)
+        {
+            fadePosition = state == State::fadingIn ? fadeLength - 1 - fadePosition : 0;
+            state = State::fadingOut;
+        }
+    }
+}
+
+float FreezeLooper::readLoop (int channel, int position) const
+{
+    // The first fadeLength samples of the loop crossfade the captured tail
+    // end into the captured start, so wrapping from loopLength - 1 to 0 is
+    // continuous
+    const auto* data = capture.getReadPointer (channel);
+
+    if (position < fadeLength)
+        return data[position] * fadeIn (position) + data[position + loopLength] * fadeOut (position);
+
+    return data[position];
+}
+
+void FreezeLooper::process (juce::AudioBuffer<float>& wet, int numSamples)
+{
+    const auto numChannels = juce::jmin (wet.getNumChannels(), capture.getNumChannels());
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        switch (state)
+        {
+            case State::idle:
+                return;
+
+            case State::capturing:
+                for (int ch = 0; ch < numChannels; ++ch)
+                    capture.setSample (ch, captured, wet.getSample (ch, i));
+
+                if (++captured == captureLength)
+                {
+                    state = State::fadingIn;
+                    loopPosition = fadeLength;
+                    fadePosition = 0;
+                }
+                break;
+
+            case State::fadingIn:
+            case State::fadingOut:
+            {
+                const auto loopGain = state == State::fadingIn ? fadeIn (fadePosition) : fadeOut (fadePosition);
+                const auto liveGain = state == State::fadingIn ? fadeOut (fadePosition) : fadeIn (fadePosition);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    wet.setSample (ch, i, wet.getSample (ch, i) * liveGain + readLoop (ch, loopPosition) * loopGain);
+
+                loopPosition = (loopPosition + 1) % loopLength;
+
+                if (++fadePosition == fadeLength)
+                    state = state == State::fadingIn ? State::looping : State::idle;
+                break;
+            }
+
+            case State::looping:
+                for (int ch = 0; ch < numChannels; ++ch)
+                    wet.setSample (ch, i, readLoop (ch, loopPosition));
+
+                loopPosition = (loopPosition + 1) % loopLength;
+                break;
+        }
+    }
+}
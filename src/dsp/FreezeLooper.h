@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ProcessingLimits.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// Plays back a frozen reverb tail as a seamless loop so the reverb network
+// can be switched off while freeze is engaged. When freeze turns on, the
+// still-running (frozen) reverb output is recorded for loopSeconds plus one
+// crossfade; after that the loop fades in over the live output and the
+// processor may stop running the reverb until freeze is released, at which
+// point the live reverb fades back in over the loop.
+class FreezeLooper final
+{
+public:
+    FreezeLooper();
+
+    // Only allocates if sampleRate exceeds ProcessingLimits::maxSampleRate or
+    // numChannels exceeds the channels allocated so far
+    void prepare (double sampleRate, int numChannels);
+    void reset();
+
+    void setFrozen (bool shouldBeFrozen);
+
+    // False while only the captured loop is audible
+    bool needsReverb() const { return state != State::looping; }
+
+    // Takes the reverb's wet output (ignored while looping) and replaces it
+    // with the frozen loop where needed
+    void process (juce::AudioBuffer<float>& wet, int numSamples);
+
+private:
+    enum class State
+    {
+        idle,
+        capturing,
+        fadingIn,
+        looping,
+        fadingOut
+    };
+
+    void allocate (double capacitySampleRate, int numChannels);
+    float readLoop (int channel, int position) const;
+    float fadeIn (int position) const { return fadeCurve[static_cast<size_t> (position)]; }
+    float fadeOut (int position) const { return fadeCurve[static_cast<size_t> (fadeLength - 1 - position)]; }
+
+    static constexpr double loopSeconds { 3.0 };
+    static constexpr double fadeSeconds { 0.25 };
+
+    State state { State::idle };
+
+    juce::AudioBuffer<float> capture;
+    std::vector<float> fadeCurve;
+
+    int loopLength {};
+    int fadeLength {};
+    int captureLength {};
+    int captured {};
+    int loopPosition {};
+    int fadePosition {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FreezeLooper)
+};
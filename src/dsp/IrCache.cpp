@@ -0,0 +1,116 @@
+#include "IrCache.h"
+#include "ProcessingLimits.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_cryptography/juce_cryptography.h>
+
+std::shared_ptr<const IrPartitions> IrCache::acquire (const juce::File& file,
+                                                     double sampleRate,
+                                                     int partitionSize,
+                                                     const IrPreparation::Options& preparation)
+{
+    juce::MemoryBlock fileData;
+
+    if (! file.loadFileAsData (fileData))
+        return nullptr;
+
+    const Key key { juce::SHA256 (fileData).toHexString(), sampleRate, partitionSize, preparation };
+
+    return acquire (key, [&fileData, &key] { return load (fileData, key); });
+}
+
+std::shared_ptr<const IrPartitions> IrCache::acquire (const Key& key, const std::function<std::unique_ptr<IrPartitions>()>& create)
+{
+    if (auto existing = find (key))
+        return existing;
+
+    std::shared_ptr<const IrDiskCache> disk;
+
+    {
+        const juce::ScopedLock sl (lock);
+        disk = diskCache;
+    }
+
+    // Loading can take a while, so it runs unlocked. If another thread loads
+    // the same key meanwhile, the first one to finish wins
+    auto loaded = disk != nullptr ? disk->load (key) : nullptr;
+
+    if (loaded == nullptr)
+    {
+        loaded = create();
+
+        if (loaded == nullptr)
+            return nullptr;
+
+        // Failing to write only costs the next session the recomputation
+        if (disk != nullptr)
+            disk->store (key, *loaded);
+    }
+
+    const juce::ScopedLock sl (lock);
+
+    if (auto existing = entries[key].lock())
+        return existing;
+
+    std::shared_ptr<const IrPartitions> partitions (loaded.release(),
+                                                    [this, key] (const IrPartitions* p)
+                                                    {
+                                                        evict (key);
+                                                        delete p;
+                                                    });
+    entries[key] = partitions;
+    return partitions;
+}
+
+int IrCache::getNumEntries() const
+{
+    const juce::ScopedLock sl (lock);
+    return static_cast<int> (entries.size());
+}
+
+void IrCache::setDiskCache (const juce::File& directory, const juce::String& buildVersion)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (diskCache == nullptr || diskCache->getDirectory() != directory || diskCache->getBuildVersion() != buildVersion)
+        diskCache = std::make_shared<const IrDiskCache> (directory, buildVersion);
+}
+
+std::shared_ptr<const IrPartitions> IrCache::find (const Key& key) const
+{
+    const juce::ScopedLock sl (lock);
+    const auto it = entries.find (key);
+    return it != entries.end() ? it->second.lock() : nullptr;
+}
+
+void IrCache::evict (const Key& key)
+{
+    const juce::ScopedLock sl (lock);
+
+    // The key may have been loaded again since this entry's last user left
+    if (const auto it = entries.find (key); it != entries.end() && it->second.expired())
+        entries.erase (it);
+}
+
+std::unique_ptr<IrPartitions> IrCache::load (const juce::MemoryBlock& fileData, const Key& key)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    const std::unique_ptr<juce::AudioFormatReader> reader (
+        formats.createReaderFor (std::make_unique<juce::MemoryInputStream> (fileData, false)));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0 || reader->numChannels == 0)
+        return nullptr;
+
+    const auto numChannels = juce::jmin (static_cast<int> (reader->numChannels), ProcessingLimits::maxChannels);
+    const auto maxLength = static_cast<juce::int64> (ProcessingLimits::maxImpulseResponseSeconds * reader->sampleRate);
+    auto numSamples = static_cast<int> (juce::jmin (reader->lengthInSamples, maxLength));
+
+    juce::AudioBuffer<float> impulseResponse (numChannels, numSamples);
+    reader->read (&impulseResponse, 0, numSamples, 0, true, true);
+
+    if (! IrPreparation::prepare (impulseResponse, numSamples, reader->sampleRate, key.sampleRate, key.preparation))
+        return nullptr;
+
+    return std::make_unique<IrPartitions> (impulseResponse, numSamples, key.partitionSize);
+}
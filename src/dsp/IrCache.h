@@ -0,0 +1,57 @@
+#pragma once
+
+#include "IrDiskCache.h"
+#include "IrPartitions.h"
+#include "IrPreparation.h"
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <map>
+#include <memory>
+
+// Process-wide cache of partitioned impulse responses. Every plugin instance
+// holds it through a juce::SharedResourcePointer, so instances loading the
+// same file at the same rate and partitioning share one immutable
+// IrPartitions instead of each reading, resampling and transforming its own
+// copy. The cache only holds weak references: an entry is evicted as soon as
+// the last instance using it lets go. With a disk cache set, a miss maps the
+// partitions from a previous session's file before falling back to computing
+// and storing them.
+class IrCache final
+{
+public:
+    using Key = IrCacheKey;
+
+    IrCache() = default;
+
+    // The partitions of file at sampleRate, read, prepared and transformed on
+    // the calling thread if no other instance holds them. Returns nullptr if
+    // the file can't be decoded or the calling thread is asked to exit.
+    // Thread-safe, but slow on a miss, so call it from a worker
+    std::shared_ptr<const IrPartitions> acquire (const juce::File& file,
+                                                 double sampleRate,
+                                                 int partitionSize,
+                                                 const IrPreparation::Options& preparation);
+
+    // The same for partitions computed rather than read, such as synthesised
+    // impulse responses. The key's hash identifies what create() computes;
+    // it is only called on a miss and may return nullptr to give up
+    std::shared_ptr<const IrPartitions> acquire (const Key& key, const std::function<std::unique_ptr<IrPartitions>()>& create);
+
+    int getNumEntries() const;
+
+    // Persists partitions under directory, valid for buildVersion only. Every
+    // instance sets the same one, later calls with it are no-ops
+    void setDiskCache (const juce::File& directory, const juce::String& buildVersion);
+
+private:
+    std::shared_ptr<const IrPartitions> find (const Key& key) const;
+    void evict (const Key& key);
+
+    static std::unique_ptr<IrPartitions> load (const juce::MemoryBlock& fileData, const Key& key);
+
+    juce::CriticalSection lock;
+    std::map<Key, std::weak_ptr<const IrPartitions>> entries;
+    std::shared_ptr<const IrDiskCache> diskCache;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IrCache)
+};
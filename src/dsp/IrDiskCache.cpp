@@ -0,0 +1,169 @@
+#include "IrDiskCache.h"
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+
+// Bump whenever the header or the spectra layout changes
+constexpr juce::uint32 formatVersion { 2 };
+constexpr juce::uint32 byteOrderMark { 0x01020304 };
+constexpr char magic[8] { '3', 'D', 'R', 'V', 'I', 'R', 'P', 'C' };
+
+// Written in native byte order, files from other architectures fail the byte
+// order check. The spectra follow at dataOffset, which keeps them aligned for
+// the SIMD kernels since mappings start on a page boundary
+struct FileHeader
+{
+    char magic[8];
+    juce::uint32 formatVersion;
+    juce::uint32 byteOrderMark;
+    juce::int32 partitionSize;
+    juce::int32 numChannels;
+    juce::int32 numPartitions;
+    juce::int32 length;
+    juce::int32 minimumPhaseHead;
+    juce::int32 reserved;
+    double sampleRate;
+    juce::uint64 dataOffset;
+    juce::uint64 dataBytes;
+    char sourceHash[65];
+    char buildVersion[63];
+};
+
+static_assert (std::is_trivially_copyable_v<FileHeader>);
+
+constexpr juce::uint64 dataOffset { 256 };
+static_assert (sizeof (FileHeader) <= dataOffset);
+
+void copyString (char* destination, size_t size, const juce::String& source)
+{
+    std::memset (destination, 0, size);
+    source.copyToUTF8 (destination, size);
+}
+
+bool matches (const char* stored, size_t size, const juce::String& expected)
+{
+    return juce::String::fromUTF8 (stored, static_cast<int> (strnlen (stored, size))) == expected;
+}
+
+} // namespace
+
+IrDiskCache::IrDiskCache (const juce::File& directoryToUse, const juce::String& buildVersionToUse)
+    : directory (directoryToUse)
+    , buildVersion (buildVersionToUse)
+{
+}
+
+juce::File IrDiskCache::getFileFor (const IrCacheKey& key) const
+{
+    return directory.getChildFile (key.sourceHash.substring (0, 32)
+                                   + "-" + juce::String (juce::roundToInt (key.sampleRate))
+                                   + "-" + juce::String (key.partitionSize)
+                                   + (key.preparation.minimumPhaseHead ? "-minphase" : "") + ".irpc");
+}
+
+std::unique_ptr<IrPartitions> IrDiskCache::load (const IrCacheKey& key) const
+{
+    const auto file = getFileFor (key);
+
+    if (! file.existsAsFile())
+        return nullptr;
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+
+    if (mapped->getData() == nullptr || mapped->getSize() < dataOffset)
+        return nullptr;
+
+    FileHeader header;
+    std::memcpy (&header, mapped->getData(), sizeof (header));
+
+    const IrPartitions::Layout layout { header.partitionSize, header.numChannels, header.numPartitions, header.length };
+
+    if (std::memcmp (header.magic, magic, sizeof (magic)) != 0
+        || header.formatVersion != formatVersion
+        || header.byteOrderMark != byteOrderMark
+        || ! matches (header.sourceHash, sizeof (header.sourceHash), key.sourceHash)
+        || ! matches (header.buildVersion, sizeof (header.buildVersion), buildVersion)
+        || ! juce::exactlyEqual (header.sampleRate, key.sampleRate)
+        || header.partitionSize != key.partitionSize
+        || (header.minimumPhaseHead != 0) != key.preparation.minimumPhaseHead
+        || layout.numChannels <= 0 || layout.numPartitions <= 0 || layout.length <= 0
+        || header.dataOffset != dataOffset
+        || header.dataBytes != layout.getDataSize() * sizeof (float)
+        || mapped->getSize() < dataOffset + header.dataBytes)
+        return nullptr;
+
+    const auto* spectra = reinterpret_cast<const float*> (static_cast<const char*> (mapped->getData()) + dataOffset);
+
+    // Fault the pages in here rather than on the audio thread's first pass
+    const auto pageFloats = static_cast<size_t> (4096 / sizeof (float));
+    volatile float sink = 0.0f;
+
+    for (size_t i = 0; i < layout.getDataSize(); i += pageFloats)
+        sink = sink + spectra[i];
+
+    return std::make_unique<IrPartitions> (layout, std::move (mapped), spectra);
+}
+
+bool IrDiskCache::store (const IrCacheKey& key, const IrPartitions& partitions) const
+{
+    if (! directory.createDirectory())
+        return false;
+
+    const auto layout = partitions.getLayout();
+
+    FileHeader header {};
+    std::memcpy (header.magic, magic, sizeof (magic));
+    header.formatVersion = formatVersion;
+    header.byteOrderMark = byteOrderMark;
+    header.partitionSize = layout.partitionSize;
+    header.numChannels = layout.numChannels;
+    header.numPartitions = layout.numPartitions;
+    header.length = layout.length;
+    header.minimumPhaseHead = key.preparation.minimumPhaseHead ? 1 : 0;
+    header.sampleRate = key.sampleRate;
+    header.dataOffset = dataOffset;
+    header.dataBytes = layout.getDataSize() * sizeof (float);
+    copyString (header.sourceHash, sizeof (header.sourceHash), key.sourceHash);
+    copyString (header.buildVersion, sizeof (header.buildVersion), buildVersion);
+
+    char headerBlock[dataOffset] {};
+    std::memcpy (headerBlock, &header, sizeof (header));
+
+    // Readers in other processes only ever see a complete file
+    const auto target = getFileFor (key);
+    juce::TemporaryFile temp (target);
+
+    {
+        juce::FileOutputStream out (temp.getFile());
+
+        if (! out.openedOk()
+            || ! out.write (headerBlock, sizeof (headerBlock))
+            || ! out.write (partitions.getData(), static_cast<size_t> (header.dataBytes)))
+            return false;
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+juce::File IrDiskCache::getDefaultDirectory (const juce::String& applicationName)
+{
+#if JUCE_MAC
+    const auto root = juce::File::getSpecialLocation (juce::File::userHomeDirectory).getChildFile ("Library/Caches");
+#elif JUCE_WINDOWS
+    const auto root = juce::File::getSpecialLocation (juce::File::windowsLocalAppData);
+#else
+    const auto xdgCacheHome = juce::SystemStats::getEnvironmentVariable ("XDG_CACHE_HOME", {});
+    const auto root = juce::File::isAbsolutePath (xdgCacheHome)
+                          ? juce::File (xdgCacheHome)
+                          : juce::File::getSpecialLocation (juce::File::userHomeDirectory).getChildFile (".cache");
+#endif
+
+    return root.getChildFile (applicationName).getChildFile ("ImpulseResponses");
+}
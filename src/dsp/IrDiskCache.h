@@ -0,0 +1,55 @@
+#pragma once
+
+#include "IrPartitions.h"
+#include "IrPreparation.h"
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <tuple>
+
+// What an impulse response is cached under
+struct IrCacheKey
+{
+    juce::String sourceHash; // of the file contents
+    double sampleRate {};
+    int partitionSize {};
+    IrPreparation::Options preparation;
+
+    bool operator< (const IrCacheKey& other) const noexcept
+    {
+        return std::tie (sourceHash, sampleRate, partitionSize, preparation.minimumPhaseHead)
+             < std::tie (other.sourceHash, other.sampleRate, other.partitionSize, other.preparation.minimumPhaseHead);
+    }
+};
+
+// Persists partitioned impulse responses across sessions, one file per key,
+// so reopening a project maps the resampled and transformed spectra straight
+// from disk instead of recomputing them. A file is only used if its header
+// matches the key, the file format and the build that wrote it; anything
+// else reads as a miss and is overwritten by the next store().
+class IrDiskCache final
+{
+public:
+    IrDiskCache (const juce::File& directoryToUse, const juce::String& buildVersionToUse);
+
+    const juce::File& getDirectory() const noexcept { return directory; }
+    const juce::String& getBuildVersion() const noexcept { return buildVersion; }
+
+    // The cached partitions for key, mapped read-only, or nullptr on a miss
+    std::unique_ptr<IrPartitions> load (const IrCacheKey& key) const;
+
+    // Writes the partitions for key, replacing any previous file atomically.
+    // Returns false if the directory isn't writable
+    bool store (const IrCacheKey& key, const IrPartitions& partitions) const;
+
+    juce::File getFileFor (const IrCacheKey& key) const;
+
+    // The per-user cache directory of the platform, in a subfolder for the
+    // application
+    static juce::File getDefaultDirectory (const juce::String& applicationName);
+
+private:
+    const juce::File directory;
+    const juce::String buildVersion;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IrDiskCache)
+};
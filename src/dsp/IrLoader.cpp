@@ -0,0 +1,67 @@
+#include "IrLoader.h"
+
+IrLoader::IrLoader (IrCache& cacheToUse, ConvolutionEngine& engineToFeed)
+    : juce::Thread ("IR loader")
+    , cache (cacheToUse)
+    , engine (engineToFeed)
+{
+    startThread (juce::Thread::Priority::background);
+}
+
+IrLoader::~IrLoader()
+{
+    // Every preparation step checks for the exit signal, so this only waits
+    // for the file read or transform in progress
+    stopThread (-1);
+}
+
+void IrLoader::request (const Request& newRequest)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        wanted = newRequest;
+    }
+
+    notify();
+}
+
+void IrLoader::run()
+{
+    while (! threadShouldExit())
+    {
+        Request next;
+
+        {
+            const juce::ScopedLock sl (lock);
+            next = wanted;
+        }
+
+        if (next == loaded)
+        {
+            wait (-1);
+            continue;
+        }
+
+        // Instances on the same file, rate, partitioning and preparation
+        // share one copy
+        auto partitions = next.file.existsAsFile()
+                            ? cache.acquire (next.file, next.sampleRate, IrPartitions::defaultPartitionSize, next.preparation)
+                            : nullptr;
+
+        auto morphTarget = partitions != nullptr && next.morphFile.existsAsFile()
+                             ? cache.acquire (next.morphFile, next.sampleRate, IrPartitions::defaultPartitionSize, next.preparation)
+                             : nullptr;
+
+        if (threadShouldExit())
+            return;
+
+        loaded = next;
+
+        if (morphTarget != nullptr)
+            engine.setImpulseResponse (std::make_shared<IrMorph> (*partitions, *morphTarget, engine.getMorphPosition()),
+                                       next.numInputChannels,
+                                       next.numOutputChannels);
+        else
+            engine.setImpulseResponse (std::move (partitions), next.numInputChannels, next.numOutputChannels);
+    }
+}
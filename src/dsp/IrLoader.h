@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ConvolutionEngine.h"
+#include "IrCache.h"
+#include "IrMorph.h"
+#include "IrPreparation.h"
+#include <juce_core/juce_core.h>
+
+// Background thread that reads, prepares and partitions impulse responses
+// through IrCache and hands them to a ConvolutionEngine, so neither the
+// message thread nor the audio thread waits on a load. With a morph file it
+// hands over an IrMorph between the two instead. Requests overtake one
+// another: only the latest is served, and one arriving mid-load is picked up
+// as soon as the current load finishes.
+class IrLoader final : private juce::Thread
+{
+public:
+    struct Request
+    {
+        juce::File file;
+        double sampleRate {};
+        int numInputChannels {};
+        int numOutputChannels {};
+        IrPreparation::Options preparation;
+        juce::File morphFile;
+
+        bool operator== (const Request&) const = default;
+    };
+
+    IrLoader (IrCache& cacheToUse, ConvolutionEngine& engineToFeed);
+    ~IrLoader() override;
+
+    // Any thread but the audio thread. Returns immediately; a request equal
+    // to what the engine was last given does nothing
+    void request (const Request& newRequest);
+
+private:
+    void run() override;
+
+    IrCache& cache;
+    ConvolutionEngine& engine;
+
+    juce::CriticalSection lock;
+    Request wanted; // guarded by lock
+    Request loaded; // worker thread only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IrLoader)
+};
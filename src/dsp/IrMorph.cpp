@@ -0,0 +1,162 @@
+#include "IrMorph.h"
+#include <cmath>
+#include <complex>
+
+namespace
+{
+
+constexpr int pollIntervalMs { 10 };
+
+IrPartitions::Layout getMorphLayout (const IrPartitions& from, const IrPartitions& to)
+{
+    jassert (from.partitionSize == to.partitionSize);
+
+    return { from.partitionSize,
+             juce::jmax (from.numChannels, to.numChannels),
+             juce::jmax (from.numPartitions, to.numPartitions),
+             juce::jmax (from.length, to.length) };
+}
+
+} // namespace
+
+IrMorph::IrMorph (const IrPartitions& from, const IrPartitions& to, float initialPosition)
+    : juce::Thread ("IR morph")
+    , layout (getMorphLayout (from, to))
+    , numBins (layout.partitionSize + 1)
+    , published (static_cast<size_t> (layout.numChannels * layout.numPartitions))
+    , publishedSlot (published.size())
+    , position (initialPosition)
+    , renderedPosition (initialPosition)
+{
+    const auto numValues = layout.getDataSize() / 2;
+    magnitudeFrom.resize (numValues);
+    magnitudeTo.resize (numValues);
+    phaseFrom.resize (numValues);
+    phaseDelta.resize (numValues);
+    slots.resize (2 * layout.getDataSize());
+
+    for (int ch = 0; ch < layout.numChannels; ++ch)
+    {
+        for (int p = 0; p < layout.numPartitions; ++p)
+        {
+            const auto offset = getBinOffset (ch, p);
+            const auto hasFrom = p < from.numPartitions;
+            const auto hasTo = p < to.numPartitions;
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                const std::complex<float> a = hasFrom ? std::complex<float> { from.getReal (ch % from.numChannels, p)[k],
+                                                                              from.getImag (ch % from.numChannels, p)[k] }
+                                                      : std::complex<float> {};
+                const std::complex<float> b = hasTo ? std::complex<float> { to.getReal (ch % to.numChannels, p)[k],
+                                                                            to.getImag (ch % to.numChannels, p)[k] }
+                                                    : std::complex<float> {};
+
+                // A silent side takes the other's phase, so only the
+                // magnitude fades
+                const auto phaseA = std::abs (a) > 0.0f ? std::arg (a) : std::arg (b);
+                const auto phaseB = std::abs (b) > 0.0f ? std::arg (b) : phaseA;
+
+                const auto i = offset + static_cast<size_t> (k);
+                magnitudeFrom[i] = std::abs (a);
+                magnitudeTo[i] = std::abs (b);
+                phaseFrom[i] = phaseA;
+                phaseDelta[i] = std::remainder (phaseB - phaseA, juce::MathConstants<float>::twoPi);
+            }
+
+            auto* slot = getSlot (ch, p, 0);
+            render (ch, p, initialPosition, slot);
+            published[static_cast<size_t> (ch * layout.numPartitions + p)].store (slot, std::memory_order_release);
+        }
+    }
+
+    startThread (juce::Thread::Priority::background);
+}
+
+IrMorph::~IrMorph()
+{
+    // A round checks for the exit signal after every partition
+    stopThread (-1);
+}
+
+void IrMorph::setPosition (float newPosition) noexcept
+{
+    position.store (newPosition, std::memory_order_relaxed);
+}
+
+void IrMorph::beginRead() noexcept
+{
+    readsStarted.fetch_add (1, std::memory_order_seq_cst);
+}
+
+void IrMorph::endRead() noexcept
+{
+    readsFinished.fetch_add (1, std::memory_order_release);
+}
+
+void IrMorph::render (int channel, int partition, float renderPosition, float* destination) const noexcept
+{
+    const auto offset = getBinOffset (channel, partition);
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        const auto i = offset + static_cast<size_t> (k);
+        const auto magnitude = magnitudeFrom[i] + renderPosition * (magnitudeTo[i] - magnitudeFrom[i]);
+        const auto phase = phaseFrom[i] + renderPosition * phaseDelta[i];
+
+        destination[k] = magnitude * std::cos (phase);
+        destination[numBins + k] = magnitude * std::sin (phase);
+    }
+}
+
+bool IrMorph::waitForReadsBefore (juce::uint64 numReads)
+{
+    while (readsFinished.load (std::memory_order_acquire) < numReads)
+    {
+        if (threadShouldExit())
+            return false;
+
+        wait (1);
+    }
+
+    return true;
+}
+
+void IrMorph::run()
+{
+    while (! threadShouldExit())
+    {
+        wait (pollIntervalMs);
+
+        const auto target = position.load (std::memory_order_relaxed);
+
+        if (juce::approximatelyEqual (target, renderedPosition))
+            continue;
+
+        // Every slot about to be written was replaced during the last round,
+        // so the passes that may have read it started before its end
+        if (! waitForReadsBefore (readsAtLastPublish))
+            return;
+
+        for (int p = 0; p < layout.numPartitions; ++p)
+        {
+            for (int ch = 0; ch < layout.numChannels; ++ch)
+            {
+                const auto index = static_cast<size_t> (ch * layout.numPartitions + p);
+                const auto slot = 1 - publishedSlot[index];
+                auto* destination = getSlot (ch, p, slot);
+
+                render (ch, p, target, destination);
+                published[index].store (destination, std::memory_order_release);
+                publishedSlot[index] = static_cast<juce::uint8> (slot);
+            }
+
+            if (threadShouldExit())
+                return;
+        }
+
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        readsAtLastPublish = readsStarted.load (std::memory_order_seq_cst);
+        renderedPosition = target;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "IrPartitions.h"
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Partition spectra interpolated between two impulse responses, for morphing
+// from one room to another with a single convolver running. Each bin's
+// magnitude and phase move separately, which avoids the comb filtering a
+// crossfade of two uncorrelated responses causes.
+//
+// A background thread renders the spectra for the latest position and
+// publishes them one partition at a time, earliest first, so the part heard
+// first follows automation soonest. Every partition has two slots; a slot is
+// only rewritten once the audio thread has finished every pass that could
+// still be reading it, tracked by the read counters around each pass.
+class IrMorph final : private juce::Thread
+{
+public:
+    // Both must share a partition size. The shorter or narrower one counts
+    // as silent where the other extends, with channels wrapping like in the
+    // convolver. Renders initialPosition on the calling thread
+    IrMorph (const IrPartitions& from, const IrPartitions& to, float initialPosition);
+    ~IrMorph() override;
+
+    const IrPartitions::Layout& getLayout() const noexcept { return layout; }
+
+    // Any thread. 0 is the first impulse response, 1 the second
+    void setPosition (float newPosition) noexcept;
+
+    // Audio thread, around every pass reading partitions
+    void beginRead() noexcept;
+    void endRead() noexcept;
+
+    // Split spectrum like IrPartitions, the imaginary parts follow numBins
+    // after the real ones
+    const float* getPartition (int channel, int partition) const noexcept
+    {
+        return published[static_cast<size_t> (channel * layout.numPartitions + partition)].load (std::memory_order_acquire);
+    }
+
+private:
+    void run() override;
+    void render (int channel, int partition, float position, float* destination) const noexcept;
+    bool waitForReadsBefore (juce::uint64 numReads);
+
+    size_t getBinOffset (int channel, int partition) const noexcept
+    {
+        return static_cast<size_t> ((channel * layout.numPartitions + partition) * numBins);
+    }
+
+    float* getSlot (int channel, int partition, int slot) noexcept
+    {
+        return slots.data() + 4 * getBinOffset (channel, partition) + static_cast<size_t> (slot * 2 * numBins);
+    }
+
+    const IrPartitions::Layout layout;
+    const int numBins;
+
+    // Per channel, partition and bin
+    std::vector<float> magnitudeFrom, magnitudeTo, phaseFrom, phaseDelta;
+
+    std::vector<float> slots;                       // two split spectra per partition
+    std::vector<std::atomic<const float*>> published; // per channel and partition
+    std::vector<juce::uint8> publishedSlot;          // worker only
+
+    std::atomic<float> position;
+    float renderedPosition;                          // worker only
+    juce::uint64 readsAtLastPublish {};              // worker only
+    std::atomic<juce::uint64> readsStarted { 0 }, readsFinished { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IrMorph)
+};
@@ -0,0 +1,57 @@
+#include "IrPartitions.h"
+#include <juce_dsp/juce_dsp.h>
+
+IrPartitions::IrPartitions (const juce::AudioBuffer<float>& impulseResponse, int numSamples, int partitionSizeToUse)
+    : partitionSize (partitionSizeToUse)
+    , fftSize (2 * partitionSizeToUse)
+    , numBins (partitionSizeToUse + 1)
+    , numChannels (impulseResponse.getNumChannels())
+    , numPartitions (juce::jmax (1, (numSamples + partitionSizeToUse - 1) / partitionSizeToUse))
+    , length (numSamples)
+{
+    jassert (juce::isPowerOfTwo (partitionSize) && numChannels > 0 && numSamples <= impulseResponse.getNumSamples());
+
+    storage.resize (getLayout().getDataSize());
+    spectra = storage.data();
+
+    juce::dsp::FFT fft (getFftOrder());
+    std::vector<float> scratch (static_cast<size_t> (2 * fftSize));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            std::fill (scratch.begin(), scratch.end(), 0.0f);
+
+            const auto start = p * partitionSize;
+            const auto count = juce::jmin (partitionSize, numSamples - start);
+
+            if (count > 0)
+                std::copy_n (impulseResponse.getReadPointer (ch, start), count, scratch.begin());
+
+            fft.performRealOnlyForwardTransform (scratch.data(), true);
+
+            auto* re = storage.data() + getOffset (ch, p);
+            auto* im = re + numBins;
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                re[k] = scratch[static_cast<size_t> (2 * k)];
+                im[k] = scratch[static_cast<size_t> (2 * k + 1)];
+            }
+        }
+    }
+}
+
+IrPartitions::IrPartitions (const Layout& layout, std::unique_ptr<juce::MemoryMappedFile> file, const float* spectraInFile)
+    : partitionSize (layout.partitionSize)
+    , fftSize (2 * layout.partitionSize)
+    , numBins (layout.partitionSize + 1)
+    , numChannels (layout.numChannels)
+    , numPartitions (layout.numPartitions)
+    , length (layout.length)
+    , mappedFile (std::move (file))
+    , spectra (spectraInFile)
+{
+    jassert (juce::isPowerOfTwo (partitionSize) && numChannels > 0 && numPartitions > 0 && mappedFile != nullptr);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <memory>
+#include <vector>
+
+// An impulse response cut into uniform partitions and transformed once, ready
+// for PartitionedConvolver. Partition p of channel ch holds the spectrum of
+// IR samples [p * partitionSize, (p + 1) * partitionSize) zero-padded to
+// fftSize = 2 * partitionSize, stored split (all real parts, then all
+// imaginary parts) so the per-bin multiply-adds are plain element-wise loops.
+//
+// Instances are immutable once created and shared between plugin instances
+// through IrCache. The spectra either live in memory or in a file mapped by
+// IrDiskCache.
+class IrPartitions final
+{
+public:
+    static constexpr int defaultPartitionSize { 512 };
+
+    struct Layout
+    {
+        int partitionSize {};
+        int numChannels {};
+        int numPartitions {};
+        int length {};
+
+        // Number of floats the spectra of this layout take
+        size_t getDataSize() const noexcept
+        {
+            return static_cast<size_t> (numChannels) * static_cast<size_t> (numPartitions)
+                 * 2 * static_cast<size_t> (partitionSize + 1);
+        }
+    };
+
+    // Partitions the first numSamples samples of every channel
+    IrPartitions (const juce::AudioBuffer<float>& impulseResponse, int numSamples, int partitionSizeToUse);
+
+    // Spectra previously written out from getData(), read in place from the
+    // mapped file, which must stay valid and hold layout.getDataSize() floats
+    // at spectraInFile
+    IrPartitions (const Layout& layout, std::unique_ptr<juce::MemoryMappedFile> file, const float* spectraInFile);
+
+    Layout getLayout() const noexcept { return { partitionSize, numChannels, numPartitions, length }; }
+    const float* getData() const noexcept { return spectra; }
+
+    int getFftOrder() const noexcept { return juce::roundToInt (std::log2 (fftSize)); }
+
+    const float* getReal (int channel, int partition) const noexcept { return spectra + getOffset (channel, partition); }
+
+    const float* getImag (int channel, int partition) const noexcept { return getReal (channel, partition) + numBins; }
+
+    const int partitionSize;
+    const int fftSize;
+    const int numBins;
+    const int numChannels;
+    const int numPartitions;
+    const int length;
+
+private:
+    size_t getOffset (int channel, int partition) const noexcept
+    {
+        return static_cast<size_t> ((channel * numPartitions + partition) * 2 * numBins);
+    }
+
+    std::vector<float> storage;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const float* spectra {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IrPartitions)
+};
@@ -0,0 +1,292 @@
+#include "IrPreparation.h"
+#include <juce_dsp/juce_dsp.h>
+#include <complex>
+#include <vector>
+
+namespace
+{
+
+constexpr double trimWindowSeconds { 0.01 };
+constexpr double trimFadeSeconds { 0.01 };
+constexpr double minimumPhaseHeadSeconds { 0.01 };
+
+// Sinc lobes on either side of the resampling kernel, its cutoff as a share
+// of the lower Nyquist frequency and its Kaiser window shape. About 100 dB of
+// stopband rejection, flat to within 0.1 dB up to 80 % of Nyquist
+constexpr int resamplerZeroCrossings { 24 };
+constexpr double resamplerPassband { 0.92 };
+constexpr double resamplerKaiserBeta { 10.0 };
+constexpr int resamplerTableResolution { 512 }; // kernel entries per source sample
+
+double besselI0 (double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; k < 64 && term > 1.0e-12 * sum; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+bool shouldExit()
+{
+    return juce::Thread::currentThreadShouldExit();
+}
+
+} // namespace
+
+namespace IrPreparation
+{
+
+bool prepare (juce::AudioBuffer<float>& impulseResponse,
+              int& numSamples,
+              double sourceRate,
+              double targetRate,
+              const Options& options)
+{
+    const auto trimmedLength = findTrimmedLength (impulseResponse, numSamples, sourceRate);
+    const auto wasTrimmed = trimmedLength < numSamples;
+    numSamples = trimmedLength;
+
+    if (shouldExit())
+        return false;
+
+    if (! juce::approximatelyEqual (sourceRate, targetRate))
+    {
+        impulseResponse = resample (impulseResponse, numSamples, sourceRate, targetRate);
+        numSamples = impulseResponse.getNumSamples();
+
+        if (shouldExit())
+            return false;
+    }
+
+    if (options.minimumPhaseHead)
+        makeHeadMinimumPhase (impulseResponse, numSamples, targetRate);
+
+    normalise (impulseResponse, numSamples);
+
+    // A cut inside the decay would otherwise end in a click
+    if (wasTrimmed)
+    {
+        const auto fadeLength = juce::jmin (numSamples / 4, juce::roundToInt (trimFadeSeconds * targetRate));
+
+        if (fadeLength > 0)
+            impulseResponse.applyGainRamp (numSamples - fadeLength, fadeLength, 1.0f, 0.0f);
+    }
+
+    return ! shouldExit();
+}
+
+int findTrimmedLength (const juce::AudioBuffer<float>& impulseResponse, int numSamples, double sampleRate)
+{
+    const auto numChannels = impulseResponse.getNumChannels();
+    const auto windowLength = juce::jmax (1, juce::roundToInt (trimWindowSeconds * sampleRate));
+    const auto numWindows = (numSamples + windowLength - 1) / windowLength;
+
+    if (numChannels == 0 || numWindows == 0)
+        return juce::jmax (1, numSamples);
+
+    std::vector<double> power (static_cast<size_t> (numWindows));
+
+    for (int w = 0; w < numWindows; ++w)
+    {
+        const auto start = w * windowLength;
+        const auto count = juce::jmin (windowLength, numSamples - start);
+        double sum = 0.0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* x = impulseResponse.getReadPointer (ch, start);
+
+            for (int i = 0; i < count; ++i)
+                sum += static_cast<double> (x[i]) * x[i];
+        }
+
+        power[static_cast<size_t> (w)] = sum / (count * numChannels);
+    }
+
+    // The last tenth of the file is taken as the noise floor. Windows in it
+    // scatter far less than 3 dB around their mean, so the tail ends where
+    // the decay last rises above that
+    const auto numFloorWindows = juce::jmax (1, numWindows / 10);
+    double floor = 0.0;
+
+    for (int w = numWindows - numFloorWindows; w < numWindows; ++w)
+        floor += power[static_cast<size_t> (w)];
+
+    floor /= numFloorWindows;
+
+    const auto peak = *std::max_element (power.begin(), power.end());
+    const auto threshold = juce::jmax (2.0 * floor, 1.0e-9 * peak);
+
+    if (peak <= 0.0)
+        return 1;
+
+    for (int w = numWindows; --w >= 0;)
+        if (power[static_cast<size_t> (w)] > threshold)
+            return juce::jmin (numSamples, (w + 1) * windowLength);
+
+    // All of it is as loud as its end
+    return numSamples;
+}
+
+juce::AudioBuffer<float> resample (const juce::AudioBuffer<float>& source, int numSamples, double sourceRate, double targetRate)
+{
+    const auto ratio = targetRate / sourceRate;
+    const auto numChannels = source.getNumChannels();
+    const auto numResampled = juce::jmax (1, static_cast<int> (std::ceil (numSamples * ratio)));
+
+    // Cutoff in cycles per source sample, and the kernel's reach in source
+    // samples, which grows when the cutoff drops for downsampling
+    const auto cutoff = 0.5 * juce::jmin (1.0, ratio) * resamplerPassband;
+    const auto halfWidth = resamplerZeroCrossings / (2.0 * cutoff);
+
+    std::vector<float> kernel (static_cast<size_t> (std::ceil (halfWidth * resamplerTableResolution)) + 2);
+    const auto windowNorm = 1.0 / besselI0 (resamplerKaiserBeta);
+
+    for (size_t i = 0; i < kernel.size(); ++i)
+    {
+        const auto t = static_cast<double> (i) / resamplerTableResolution;
+        const auto u = t / halfWidth;
+
+        if (u >= 1.0)
+            break;
+
+        const auto x = juce::MathConstants<double>::pi * 2.0 * cutoff * t;
+        const auto sinc = i == 0 ? 1.0 : std::sin (x) / x;
+        kernel[i] = static_cast<float> (2.0 * cutoff * sinc * besselI0 (resamplerKaiserBeta * std::sqrt (1.0 - u * u)) * windowNorm);
+    }
+
+    auto lookup = [&kernel] (double distance)
+    {
+        const auto position = std::abs (distance) * resamplerTableResolution;
+        const auto index = static_cast<size_t> (position);
+
+        if (index + 1 >= kernel.size())
+            return 0.0f;
+
+        const auto frac = static_cast<float> (position - static_cast<double> (index));
+        return kernel[index] + frac * (kernel[index + 1] - kernel[index]);
+    };
+
+    juce::AudioBuffer<float> resampled (numChannels, numResampled);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* x = source.getReadPointer (ch);
+        auto* y = resampled.getWritePointer (ch);
+
+        for (int n = 0; n < numResampled; ++n)
+        {
+            if ((n & 4095) == 0 && shouldExit())
+                return resampled;
+
+            const auto t = n / ratio;
+            const auto first = juce::jmax (0, static_cast<int> (std::ceil (t - halfWidth)));
+            const auto last = juce::jmin (numSamples - 1, static_cast<int> (std::floor (t + halfWidth)));
+            float sum = 0.0f;
+
+            for (int k = first; k <= last; ++k)
+                sum += x[k] * lookup (t - k);
+
+            y[n] = sum;
+        }
+    }
+
+    return resampled;
+}
+
+void makeHeadMinimumPhase (juce::AudioBuffer<float>& impulseResponse, int numSamples, double sampleRate)
+{
+    // Homomorphic method: the causal part of the real cepstrum of the head,
+    // doubled, is the cepstrum of the minimum-phase filter with the same
+    // magnitude response. Zero padding keeps the cepstrum from aliasing
+    const auto headLength = juce::jmin (numSamples, juce::roundToInt (minimumPhaseHeadSeconds * sampleRate));
+
+    if (headLength < 16)
+        return;
+
+    const auto order = juce::jlimit (4, 20, juce::roundToInt (std::ceil (std::log2 (8.0 * headLength))));
+    const auto fftSize = 1 << order;
+    juce::dsp::FFT fft (order);
+
+    using Complex = std::complex<float>;
+    std::vector<Complex> time (static_cast<size_t> (fftSize)), frequency (time.size());
+
+    // The last quarter of the head blends back into the original response
+    const auto fadeLength = headLength / 4;
+    const auto fadeStart = headLength - fadeLength;
+
+    for (int ch = 0; ch < impulseResponse.getNumChannels(); ++ch)
+    {
+        auto* x = impulseResponse.getWritePointer (ch);
+
+        std::fill (time.begin(), time.end(), Complex {});
+
+        for (int i = 0; i < headLength; ++i)
+            time[static_cast<size_t> (i)] = x[i];
+
+        fft.perform (time.data(), frequency.data(), false);
+
+        float peak = 0.0f;
+
+        for (auto& bin : frequency)
+            peak = juce::jmax (peak, std::abs (bin));
+
+        if (peak <= 0.0f)
+            continue;
+
+        const auto floor = peak * 1.0e-6f;
+
+        for (auto& bin : frequency)
+            bin = std::log (juce::jmax (std::abs (bin), floor));
+
+        fft.perform (frequency.data(), time.data(), true);
+
+        for (int i = 1; i < fftSize / 2; ++i)
+            time[static_cast<size_t> (i)] = 2.0f * time[static_cast<size_t> (i)].real();
+
+        time[0] = time[0].real();
+        time[static_cast<size_t> (fftSize / 2)] = time[static_cast<size_t> (fftSize / 2)].real();
+        std::fill (time.begin() + fftSize / 2 + 1, time.end(), Complex {});
+
+        fft.perform (time.data(), frequency.data(), false);
+
+        for (auto& bin : frequency)
+            bin = std::exp (bin);
+
+        fft.perform (frequency.data(), time.data(), true);
+
+        for (int i = 0; i < headLength; ++i)
+        {
+            const auto minimumPhase = time[static_cast<size_t> (i)].real();
+            const auto original = i < fadeStart ? 0.0f
+                                                : 0.5f - 0.5f * std::cos (juce::MathConstants<float>::pi * (i - fadeStart) / fadeLength);
+            x[i] = minimumPhase + original * (x[i] - minimumPhase);
+        }
+    }
+}
+
+void normalise (juce::AudioBuffer<float>& impulseResponse, int numSamples)
+{
+    double loudest = 0.0;
+
+    for (int ch = 0; ch < impulseResponse.getNumChannels(); ++ch)
+    {
+        const auto* x = impulseResponse.getReadPointer (ch);
+        double energy = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+            energy += static_cast<double> (x[i]) * x[i];
+
+        loudest = juce::jmax (loudest, energy);
+    }
+
+    if (loudest > 0.0)
+        impulseResponse.applyGain (0, numSamples, static_cast<float> (1.0 / std::sqrt (loudest)));
+}
+
+} // namespace IrPreparation
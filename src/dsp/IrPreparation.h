@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// Offline conditioning applied to an impulse response before it is
+// partitioned: the silent tail is cut so no partitions convolve noise floor,
+// the rest is brought to the playback rate, optionally given a minimum-phase
+// head and normalised. Slow, so it runs wherever IrCache::acquire() is
+// called. Every step gives up early when the calling juce::Thread is asked to
+// exit, and prepare() then returns false.
+namespace IrPreparation
+{
+
+struct Options
+{
+    // Replaces the first few milliseconds with their minimum-phase
+    // equivalent, which moves energy smeared ahead of the direct sound
+    // behind it
+    bool minimumPhaseHead { false };
+
+    bool operator== (const Options&) const = default;
+};
+
+// Brings the first numSamples samples of impulseResponse from sourceRate to
+// targetRate, trimmed, conditioned and normalised. numSamples is updated to
+// the prepared length
+bool prepare (juce::AudioBuffer<float>& impulseResponse,
+              int& numSamples,
+              double sourceRate,
+              double targetRate,
+              const Options& options);
+
+// Where the energy of all channels together has decayed into the noise floor
+// measured at the end, or 90 dB below its peak. At least one sample
+int findTrimmedLength (const juce::AudioBuffer<float>& impulseResponse, int numSamples, double sampleRate);
+
+// Windowed sinc resampling, band-limited to the lower of the two rates
+juce::AudioBuffer<float> resample (const juce::AudioBuffer<float>& source, int numSamples, double sourceRate, double targetRate);
+
+void makeHeadMinimumPhase (juce::AudioBuffer<float>& impulseResponse, int numSamples, double sampleRate);
+
+// Scales every channel by the same gain so the loudest one has unit energy,
+// which keeps white noise at the same level through the convolution
+void normalise (juce::AudioBuffer<float>& impulseResponse, int numSamples);
+
+} // namespace IrPreparation
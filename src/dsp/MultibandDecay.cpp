@@ -0,0 +1,65 @@
+#include "MultibandDecay.h"
+#include <juce_core/juce_core.h>
+#include <cmath>
+
+namespace
+{
+
+// A first-order section, numerator and denominator, not normalised
+struct FirstOrder
+{
+    double b0, b1, a0, a1;
+};
+
+// Bilinear transforms of (s + w sqrt g) / (s + w / sqrt g) and its mirror
+// image, which have gain g at DC (low) or Nyquist (high), unity at the other
+// end and sqrt g at the crossover w
+FirstOrder makeLowShelf (double gain, double crossover, double sampleRate) noexcept
+{
+    const auto t = std::tan (juce::MathConstants<double>::pi * crossover / sampleRate);
+    const auto root = std::sqrt (gain);
+    return { 1.0 + t * root, t * root - 1.0, 1.0 + t / root, t / root - 1.0 };
+}
+
+FirstOrder makeHighShelf (double gain, double crossover, double sampleRate) noexcept
+{
+    const auto t = std::tan (juce::MathConstants<double>::pi * crossover / sampleRate);
+    const auto root = std::sqrt (gain);
+    return { root + t, t - root, 1.0 / root + t, t - 1.0 / root };
+}
+
+} // namespace
+
+double MultibandDecay::getGainPerTrip (double seconds, int lineSize, double sampleRate) noexcept
+{
+    return std::pow (10.0, -3.0 * lineSize / (juce::jmax (0.01, seconds) * sampleRate));
+}
+
+void MultibandDecay::design (double sampleRate,
+                             const int32_t* lineSizes,
+                             int numLanes,
+                             SimdKernels::CombBank::DecayFilters& filters) const noexcept
+{
+    // Both crossovers stay clear of Nyquist and of each other
+    const auto nyquist = 0.5 * sampleRate;
+    const auto high = juce::jlimit (20.0, 0.9 * nyquist, static_cast<double> (highCrossover));
+    const auto low = juce::jlimit (10.0, 0.5 * high, static_cast<double> (lowCrossover));
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto size = lineSizes[lane];
+        const auto mid = getGainPerTrip (midSeconds, size, sampleRate);
+        const auto lowShelf = makeLowShelf (getGainPerTrip (lowSeconds, size, sampleRate) / mid, low, sampleRate);
+        const auto highShelf = makeHighShelf (getGainPerTrip (highSeconds, size, sampleRate) / mid, high, sampleRate);
+
+        // The product of the two sections, normalised
+        const auto a0 = lowShelf.a0 * highShelf.a0;
+        const auto scale = mid / a0;
+
+        filters.b0[lane] = static_cast<float> (scale * lowShelf.b0 * highShelf.b0);
+        filters.b1[lane] = static_cast<float> (scale * (lowShelf.b0 * highShelf.b1 + lowShelf.b1 * highShelf.b0));
+        filters.b2[lane] = static_cast<float> (scale * lowShelf.b1 * highShelf.b1);
+        filters.a1[lane] = static_cast<float> ((lowShelf.a0 * highShelf.a1 + lowShelf.a1 * highShelf.a0) / a0);
+        filters.a2[lane] = static_cast<float> (lowShelf.a1 * highShelf.a1 / a0);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "SimdKernels.h"
+#include <cstdint>
+
+// Reverberation times for three bands split at two crossovers, for the comb
+// lines to decay at in place of a single feedback level and a one-pole
+// damping. Every line gets a filter whose gain in each band is the line's
+// loss per trip at that band's rate: a first-order low shelf and high shelf
+// around the mid band's gain, combined into one biquad. Since the loss per
+// trip depends on the line's length, so does every line's filter.
+struct MultibandDecay
+{
+    float lowSeconds { 2.0f };
+    float midSeconds { 1.5f };
+    float highSeconds { 0.7f };
+    float lowCrossover { 250.0f };   // Hz
+    float highCrossover { 4000.0f }; // Hz
+
+    bool operator== (const MultibandDecay&) const = default;
+
+    // Lanes [0, numLanes) of filters, for lines of lineSizes samples
+    void design (double sampleRate, const int32_t* lineSizes, int numLanes, SimdKernels::CombBank::DecayFilters& filters) const noexcept;
+
+    // The gain per trip a line of lineSize samples needs for a decay of 60
+    // dB in seconds
+    static double getGainPerTrip (double seconds, int lineSize, double sampleRate) noexcept;
+};
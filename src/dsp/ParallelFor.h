@@ -0,0 +1,38 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Runs job (0) to job (numJobs - 1) on pool and waits for all of them. Not to
+// be called from one of pool's own threads, which could end up waiting on
+// jobs queued behind itself
+inline void parallelFor (juce::ThreadPool& pool, int numJobs, const std::function<void (int)>& job)
+{
+    // Shared, as the last job may still be inside signal() when wait() returns
+    struct Progress
+    {
+        std::atomic<int> remaining;
+        juce::WaitableEvent done;
+    };
+
+    if (numJobs <= 0)
+        return;
+
+    auto progress = std::make_shared<Progress>();
+    progress->remaining = numJobs;
+
+    for (int i = 0; i < numJobs; ++i)
+    {
+        pool.addJob ([progress, &job, i]
+                     {
+                         job (i);
+
+                         if (--progress->remaining == 0)
+                             progress->done.signal();
+                     });
+    }
+
+    progress->done.wait();
+}
@@ -0,0 +1,277 @@
+#include "PartitionedConvolver.h"
+
+namespace
+{
+
+// acc += x * h on split complex spectra
+void multiplyAdd (const float* xRe, const float* xIm, const float* hRe, const float* hIm, float* accRe, float* accIm, int numBins) noexcept
+{
+    for (int k = 0; k < numBins; ++k)
+    {
+        accRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+        accIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+    }
+}
+
+// Over independent lanes, so it vectorises without reordering a single sum
+float dotProduct (const float* a, const float* b, int length) noexcept
+{
+    constexpr int numLanes { 8 };
+    float sums[numLanes] {};
+    int i = 0;
+
+    for (; i + numLanes <= length; i += numLanes)
+        for (int lane = 0; lane < numLanes; ++lane)
+            sums[lane] += a[i + lane] * b[i + lane];
+
+    float sum = 0.0f;
+
+    for (; i < length; ++i)
+        sum += a[i] * b[i];
+
+    for (auto s : sums)
+        sum += s;
+
+    return sum;
+}
+
+} // namespace
+
+PartitionedConvolver::PartitionedConvolver (std::shared_ptr<const IrPartitions> impulseResponse,
+                                            int numInputChannels,
+                                            int numOutputChannels)
+    : PartitionedConvolver (impulseResponse->getLayout(), numInputChannels, numOutputChannels)
+{
+    ir = std::move (impulseResponse);
+    updateHeads();
+}
+
+PartitionedConvolver::PartitionedConvolver (std::shared_ptr<IrMorph> morphToUse, int numInputChannels, int numOutputChannels)
+    : PartitionedConvolver (morphToUse->getLayout(), numInputChannels, numOutputChannels)
+{
+    morph = std::move (morphToUse);
+}
+
+PartitionedConvolver::PartitionedConvolver (const IrPartitions::Layout& layout, int numInputChannels, int numOutputChannels)
+    : numInputs (numInputChannels)
+    , numOutputs (numOutputChannels)
+    , blockSize (layout.partitionSize)
+    , numBins (layout.partitionSize + 1)
+    , numPartitions (layout.numPartitions)
+    , numIrChannels (layout.numChannels)
+    , fft (juce::roundToInt (std::log2 (2 * layout.partitionSize)))
+{
+    jassert (numInputs > 0 && numOutputs >= numInputs);
+
+    windows.resize (static_cast<size_t> (numInputs * 2 * blockSize));
+    history.resize (static_cast<size_t> (numInputs * numPartitions * 2 * numBins));
+    tails.resize (static_cast<size_t> (2 * numOutputs * 2 * numBins));
+    tailOutputs.resize (static_cast<size_t> (numOutputs * blockSize));
+    heads.resize (static_cast<size_t> (numIrChannels * blockSize));
+    scratch.resize (static_cast<size_t> (4 * blockSize));
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    std::fill (windows.begin(), windows.end(), 0.0f);
+    std::fill (history.begin(), history.end(), 0.0f);
+    std::fill (tails.begin(), tails.end(), 0.0f);
+    std::fill (tailOutputs.begin(), tailOutputs.end(), 0.0f);
+    position = 0;
+    newest = 0;
+    nextPartition = 2;
+    currentTails = 0;
+}
+
+float* PartitionedConvolver::getWindow (int input) noexcept
+{
+    return windows.data() + static_cast<size_t> (input * 2 * blockSize);
+}
+
+
+float* PartitionedConvolver::getHistory (int input, int slot) noexcept
+{
+    return history.data() + static_cast<size_t> ((input * numPartitions + slot) * 2 * numBins);
+}
+
+float* PartitionedConvolver::getTail (int output) noexcept
+{
+    return tails.data() + static_cast<size_t> ((currentTails * numOutputs + output) * 2 * numBins);
+}
+
+float* PartitionedConvolver::getNextTail (int output) noexcept
+{
+    return tails.data() + static_cast<size_t> (((1 - currentTails) * numOutputs + output) * 2 * numBins);
+}
+
+float* PartitionedConvolver::getTailOutput (int output) noexcept
+{
+    return tailOutputs.data() + static_cast<size_t> (output * blockSize);
+}
+
+float* PartitionedConvolver::getHead (int irChannel) noexcept
+{
+    return heads.data() + static_cast<size_t> (irChannel * blockSize);
+}
+
+void PartitionedConvolver::updateHeads() noexcept
+{
+    for (int irChannel = 0; irChannel < numIrChannels; ++irChannel)
+    {
+        const auto* hRe = getPartition (irChannel, 0);
+        const auto* hIm = hRe + numBins;
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            scratch[static_cast<size_t> (2 * k)] = hRe[k];
+            scratch[static_cast<size_t> (2 * k + 1)] = hIm[k];
+        }
+
+        fft.performRealOnlyInverseTransform (scratch.data());
+        std::reverse_copy (scratch.begin(), scratch.begin() + blockSize, getHead (irChannel));
+    }
+}
+
+void PartitionedConvolver::transformWindow (int input, float* spectrum) noexcept
+{
+    const auto* window = getWindow (input);
+    std::copy_n (window, 2 * blockSize, scratch.begin());
+    fft.performRealOnlyForwardTransform (scratch.data(), true);
+
+    auto* re = spectrum;
+    auto* im = re + numBins;
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        re[k] = scratch[static_cast<size_t> (2 * k)];
+        im[k] = scratch[static_cast<size_t> (2 * k + 1)];
+    }
+}
+
+void PartitionedConvolver::setMorphPosition (float newPosition) noexcept
+{
+    if (morph != nullptr)
+        morph->setPosition (newPosition);
+}
+
+void PartitionedConvolver::process (float* const* channels, int numSamples) noexcept
+{
+    // Holds the morph's spectra still for this pass
+    if (morph != nullptr)
+        morph->beginRead();
+
+    for (int start = 0; start < numSamples;)
+    {
+        const auto n = juce::jmin (numSamples - start, blockSize - position);
+
+        // A morph's first partition is picked up once per block
+        if (morph != nullptr && position == 0)
+            updateHeads();
+
+        // The window is the previous block followed by the current one
+        for (int input = 0; input < numInputs; ++input)
+            std::copy_n (channels[input] + start, n, getWindow (input) + blockSize + position);
+
+        // The first partition over the blockSize samples up to each one, on
+        // top of the later partitions' sum for it
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            const auto* window = getWindow (getInputFor (output));
+            const auto* head = getHead (getIrChannelFor (output));
+            const auto* tailOutput = getTailOutput (output) + position;
+            auto* out = channels[output] + start;
+
+            for (int i = 0; i < n; ++i)
+                out[i] = tailOutput[i] + dotProduct (head, window + position + i + 1, blockSize);
+        }
+
+        position += n;
+        start += n;
+
+        if (position == blockSize)
+            completeBlock();
+        else if (numPartitions > 2)
+            accumulateNextTails (2 + (numPartitions - 2) * position / blockSize);
+    }
+
+    if (morph != nullptr)
+        morph->endRead();
+}
+
+void PartitionedConvolver::accumulateNextTails (int endPartition) noexcept
+{
+    // The next block meets partition p with the block completed p - 2 blocks
+    // before the newest
+    for (; nextPartition < endPartition; ++nextPartition)
+    {
+        const auto slot = (newest - nextPartition + 2 + numPartitions) % numPartitions;
+
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            const auto* x = getHistory (getInputFor (output), slot);
+            const auto irChannel = getIrChannelFor (output);
+            auto* tail = getNextTail (output);
+
+            const auto* h = getPartition (irChannel, nextPartition);
+            multiplyAdd (x, x + numBins, h, h + numBins, tail, tail + numBins, numBins);
+        }
+    }
+}
+
+void PartitionedConvolver::completeBlock() noexcept
+{
+    // Whatever the last calls left over, before newest moves
+    accumulateNextTails (numPartitions);
+
+    position = 0;
+    newest = (newest + 1) % numPartitions;
+
+    for (int input = 0; input < numInputs; ++input)
+    {
+        transformWindow (input, getHistory (input, newest));
+
+        auto* window = getWindow (input);
+        std::copy_n (window + blockSize, blockSize, window);
+        std::fill_n (window + blockSize, blockSize, 0.0f);
+    }
+
+    // Partition 1 meets the block just completed, which completes the sum
+    // and leaves only partition 0 for the calls to come
+    if (numPartitions > 1)
+    {
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            const auto* x = getHistory (getInputFor (output), newest);
+            const auto irChannel = getIrChannelFor (output);
+            auto* tail = getNextTail (output);
+
+            const auto* h = getPartition (irChannel, 1);
+            multiplyAdd (x, x + numBins, h, h + numBins, tail, tail + numBins, numBins);
+        }
+    }
+
+    currentTails = 1 - currentTails;
+    nextPartition = 2;
+
+    for (int output = 0; output < numOutputs; ++output)
+        std::fill_n (getNextTail (output), 2 * numBins, 0.0f);
+
+    // The sum is complete for every sample of the next block, so it goes
+    // back to the time domain once rather than on every call
+    if (numPartitions > 1)
+    {
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            const auto* tail = getTail (output);
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                scratch[static_cast<size_t> (2 * k)] = tail[k];
+                scratch[static_cast<size_t> (2 * k + 1)] = tail[numBins + k];
+            }
+
+            fft.performRealOnlyInverseTransform (scratch.data());
+            std::copy_n (scratch.begin() + blockSize, blockSize, getTailOutput (output));
+        }
+    }
+}
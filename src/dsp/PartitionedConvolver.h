@@ -0,0 +1,92 @@
+#pragma once
+
+#include "IrMorph.h"
+#include "IrPartitions.h"
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+#include <vector>
+
+// Uniformly partitioned overlap-save convolution with no added latency. The
+// first partition runs as a direct FIR on the samples as they arrive, so its
+// cost follows the number of samples in a call. All later partitions only
+// see completed blocks: each block is transformed once when it completes,
+// and their sum for the next block is transformed back once then.
+//
+// The frequency-domain work for the next block is spread over the calls
+// filling the current one instead of landing on the one that completes it:
+// partitions 2 and up only need blocks that are already complete and are
+// accumulated in step with the samples processed, leaving partition 1, the
+// newest block's transform and the inverse of the sum for completion. So
+// apart from that, the cost per sample does not grow as host blocks shrink.
+//
+// Each input channel keeps one history of block spectra however many outputs
+// read it. Output channel ch reads input min (ch, numInputChannels - 1) and
+// IR channel ch % IR channels, so a mono input on a stereo IR runs one
+// history and two outputs. Everything is allocated in the constructor.
+//
+// The partitions come from a fixed IrPartitions or from an IrMorph, whose
+// spectra may change between calls.
+class PartitionedConvolver final
+{
+public:
+    PartitionedConvolver (std::shared_ptr<const IrPartitions> impulseResponse, int numInputChannels, int numOutputChannels);
+    PartitionedConvolver (std::shared_ptr<IrMorph> morphToUse, int numInputChannels, int numOutputChannels);
+
+    void reset() noexcept;
+
+    // In place on numOutputChannels channels. All inputs are read before any
+    // output is written, so inputs may be shared with outputs
+    void process (float* const* channels, int numSamples) noexcept;
+
+    int getNumInputChannels() const noexcept { return numInputs; }
+    int getNumOutputChannels() const noexcept { return numOutputs; }
+
+    // Does nothing without a morph
+    void setMorphPosition (float newPosition) noexcept;
+
+private:
+    PartitionedConvolver (const IrPartitions::Layout& layout, int numInputChannels, int numOutputChannels);
+
+    int getInputFor (int output) const noexcept { return juce::jmin (output, numInputs - 1); }
+    int getIrChannelFor (int output) const noexcept { return output % numIrChannels; }
+
+    // Split spectrum of an IR partition, imaginary parts numBins after the
+    // real ones
+    const float* getPartition (int irChannel, int partition) const noexcept
+    {
+        return morph != nullptr ? morph->getPartition (irChannel, partition) : ir->getReal (irChannel, partition);
+    }
+
+    float* getWindow (int input) noexcept;
+    float* getHistory (int input, int slot) noexcept;
+    float* getTail (int output) noexcept;
+    float* getNextTail (int output) noexcept;
+    float* getTailOutput (int output) noexcept;
+    float* getHead (int irChannel) noexcept;
+
+    // Takes the first partition's taps out of its spectrum, reversed
+    void updateHeads() noexcept;
+    void transformWindow (int input, float* spectrum) noexcept;
+    void accumulateNextTails (int endPartition) noexcept;
+    void completeBlock() noexcept;
+
+    std::shared_ptr<const IrPartitions> ir;
+    std::shared_ptr<IrMorph> morph;
+    const int numInputs, numOutputs;
+    const int blockSize, numBins, numPartitions, numIrChannels;
+    juce::dsp::FFT fft;
+
+    int position {}; // samples of the current block filled so far
+    int newest {};   // history slot of the last completed block
+    int nextPartition { 2 }; // next partition accumulated for the next block
+    int currentTails {};     // which half of tails the current block reads
+
+    std::vector<float> windows;          // per input, previous and current block
+    std::vector<float> history;          // per input, numPartitions split spectra
+    std::vector<float> tails;            // per output, current and next sum over partitions 1..n-1
+    std::vector<float> tailOutputs;      // per output, the current sum over the block's samples
+    std::vector<float> heads;            // per IR channel, the first partition's taps reversed
+    std::vector<float> scratch;          // interleaved FFT buffer
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PartitionedConvolver)
+};
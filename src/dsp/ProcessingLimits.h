@@ -0,0 +1,17 @@
+#pragma once
+
+// Capacities everything on the audio path is allocated for up front, so that
+// re-preparing for any rate or block size within them never allocates.
+// Per-channel delay memory is only allocated for preallocatedChannels up
+// front; preparing for a wider bus layout allocates once when it is first
+// seen.
+namespace ProcessingLimits
+{
+
+inline constexpr double maxSampleRate { 192000.0 };
+inline constexpr int maxChannels { 12 }; // 7.1.4
+inline constexpr int preallocatedChannels { 2 };
+inline constexpr int maxBlockSize { 2048 }; // longer host blocks are processed in chunks
+inline constexpr double maxImpulseResponseSeconds { 20.0 }; // longer files are cut
+
+} // namespace ProcessingLimits
@@ -0,0 +1,248 @@
+#include "ReflectionFilterBank.h"
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <numeric>
+
+namespace
+{
+
+using Response = ReflectionFilterBank::Response;
+
+constexpr int numSections { ReflectionFilterBank::numSections };
+constexpr int numFitIterations { 4 };
+
+// Bands further below the loudest than this are fitted as if they were only
+// this far down. Biquads stretched across a wider range stop converging, and
+// such a reflection is inaudible in those bands either way
+constexpr float maxSpreadDb { 40.0f };
+
+// A shelf below the lowest band centre, one peak on each band centre in
+// between and a shelf above the highest, as in a graphic equaliser
+constexpr float peakQ { 1.0f };
+
+float getSectionFrequency (int section)
+{
+    const auto& centres = RoomMaterials::bandCentres;
+
+    if (section == 0)
+        return std::sqrt (centres[0] * centres[1]);
+
+    if (section == numSections - 1)
+        return std::sqrt (centres[numSections - 2] * centres[numSections - 1]);
+
+    return centres[static_cast<size_t> (section)];
+}
+
+std::array<float, 6> getSectionCoefficients (int section, float gainDb, double sampleRate)
+{
+    using Coefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+    const auto gain = juce::Decibels::decibelsToGain (gainDb, -300.0f);
+    const auto frequency = getSectionFrequency (section);
+    const auto shelfQ = juce::MathConstants<float>::sqrt2 / 2.0f;
+
+    if (section == 0)
+        return Coefficients::makeLowShelf (sampleRate, frequency, shelfQ, gain);
+
+    if (section == numSections - 1)
+        return Coefficients::makeHighShelf (sampleRate, frequency, shelfQ, gain);
+
+    return Coefficients::makePeakFilter (sampleRate, frequency, peakQ, gain);
+}
+
+float getSectionMagnitudeDb (int section, float gainDb, double sampleRate, float frequency)
+{
+    const auto c = getSectionCoefficients (section, gainDb, sampleRate);
+    const auto z = std::polar (1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+    const auto numerator = static_cast<double> (c[0]) + z * (static_cast<double> (c[1]) + z * static_cast<double> (c[2]));
+    const auto denominator = static_cast<double> (c[3]) + z * (static_cast<double> (c[4]) + z * static_cast<double> (c[5]));
+    return static_cast<float> (20.0 * std::log10 (std::abs (numerator) / std::abs (denominator)));
+}
+
+// Solves matrix x = rhs by Gaussian elimination with partial pivoting
+std::array<double, numSections> solve (std::array<std::array<double, numSections + 1>, numSections> m)
+{
+    for (size_t column = 0; column < numSections; ++column)
+    {
+        auto pivot = column;
+
+        for (auto row = column + 1; row < numSections; ++row)
+            if (std::abs (m[row][column]) > std::abs (m[pivot][column]))
+                pivot = row;
+
+        std::swap (m[column], m[pivot]);
+
+        for (auto row = column + 1; row < numSections; ++row)
+        {
+            const auto factor = m[row][column] / m[column][column];
+
+            for (auto j = column; j <= numSections; ++j)
+                m[row][j] -= factor * m[column][j];
+        }
+    }
+
+    std::array<double, numSections> solution {};
+
+    for (int row = numSections; --row >= 0;)
+    {
+        const auto r = static_cast<size_t> (row);
+        auto sum = m[r][numSections];
+
+        for (auto j = r + 1; j < numSections; ++j)
+            sum -= m[r][j] * solution[j];
+
+        solution[r] = sum / m[r][r];
+    }
+
+    return solution;
+}
+
+} // namespace
+
+void ReflectionFilterBank::Response::add (const Response& other, float times) noexcept
+{
+    gainDb += times * other.gainDb;
+
+    for (size_t section = 0; section < numSections; ++section)
+        sectionGainsDb[section] += times * other.sectionGainsDb[section];
+}
+
+ReflectionFilterBank::Response ReflectionFilterBank::fit (const RoomMaterials::BandValues& absorption, double sampleRate)
+{
+    RoomMaterials::BandValues targetDb;
+
+    for (size_t band = 0; band < RoomMaterials::numBands; ++band)
+        targetDb[band] = 10.0f * std::log10 (juce::jlimit (1.0e-6f, 1.0f, 1.0f - absorption[band]));
+
+    // The broadband gain takes the mean, so the sections only shape
+    Response response;
+    response.gainDb = std::accumulate (targetDb.begin(), targetDb.end(), 0.0f) / static_cast<float> (RoomMaterials::numBands);
+
+    for (int i = 0; i < numFitIterations; ++i)
+        refine (response, targetDb, sampleRate);
+
+    return response;
+}
+
+void ReflectionFilterBank::refine (Response& response, const RoomMaterials::BandValues& targetDb, double sampleRate)
+{
+    // A Newton step: how every section moves every band centre per dB about
+    // its current gain, against what is still missing there
+    std::array<std::array<double, numSections + 1>, numSections> system {};
+    const auto loudest = *std::max_element (targetDb.begin(), targetDb.end());
+
+    for (size_t band = 0; band < RoomMaterials::numBands; ++band)
+    {
+        const auto frequency = RoomMaterials::bandCentres[band];
+        system[band][numSections] = juce::jmax (targetDb[band], loudest - maxSpreadDb) - getMagnitudeDb (response, sampleRate, frequency);
+
+        for (int section = 0; section < numSections; ++section)
+        {
+            const auto gainDb = response.sectionGainsDb[static_cast<size_t> (section)];
+            system[band][static_cast<size_t> (section)] = getSectionMagnitudeDb (section, gainDb + 1.0f, sampleRate, frequency)
+                                                        - getSectionMagnitudeDb (section, gainDb, sampleRate, frequency);
+        }
+    }
+
+    const auto step = solve (system);
+
+    for (size_t section = 0; section < numSections; ++section)
+        response.sectionGainsDb[section] += static_cast<float> (step[section]);
+}
+
+const ReflectionFilterBank::Response& ReflectionFilterBank::getMaterialResponse (int id, double sampleRate)
+{
+    static juce::CriticalSection lock;
+    static std::map<double, std::vector<Response>> responses;
+
+    const juce::ScopedLock sl (lock);
+    auto& forRate = responses[sampleRate];
+
+    if (forRate.empty())
+        for (int material = 0; material < RoomMaterials::numMaterials; ++material)
+            forRate.push_back (fit (RoomMaterials::get (material).absorption, sampleRate));
+
+    return forRate[static_cast<size_t> (id >= 0 && id < RoomMaterials::numMaterials ? id : 0)];
+}
+
+float ReflectionFilterBank::getMagnitudeDb (const Response& response, double sampleRate, float frequency)
+{
+    auto magnitudeDb = response.gainDb;
+
+    for (int section = 0; section < numSections; ++section)
+        magnitudeDb += getSectionMagnitudeDb (section, response.sectionGainsDb[static_cast<size_t> (section)], sampleRate, frequency);
+
+    return magnitudeDb;
+}
+
+void ReflectionFilterBank::prepare (int newNumLanes, double newSampleRate)
+{
+    numLanes = newNumLanes;
+    sampleRate = newSampleRate;
+    coefficients.assign (static_cast<size_t> (numSections * numCoefficients * numLanes), 0.0f);
+    gains.assign (static_cast<size_t> (numLanes), 0.0f);
+    state.assign (static_cast<size_t> (numSections * 2 * numLanes), 0.0f);
+}
+
+void ReflectionFilterBank::setLane (int lane, const Response& response)
+{
+    jassert (juce::isPositiveAndBelow (lane, numLanes));
+
+    gains[static_cast<size_t> (lane)] = juce::Decibels::decibelsToGain (response.gainDb, -300.0f);
+
+    for (int section = 0; section < numSections; ++section)
+    {
+        const auto c = getSectionCoefficients (section, response.sectionGainsDb[static_cast<size_t> (section)], sampleRate);
+        const auto a0 = c[3];
+
+        getCoefficient (section, b0, lane) = c[0] / a0;
+        getCoefficient (section, b1, lane) = c[1] / a0;
+        getCoefficient (section, b2, lane) = c[2] / a0;
+        getCoefficient (section, a1, lane) = c[4] / a0;
+        getCoefficient (section, a2, lane) = c[5] / a0;
+    }
+}
+
+void ReflectionFilterBank::reset() noexcept
+{
+    std::fill (state.begin(), state.end(), 0.0f);
+}
+
+void ReflectionFilterBank::process (float* frames, int numFrames) noexcept
+{
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        auto* x = frames + static_cast<size_t> (frame) * static_cast<size_t> (numLanes);
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            x[lane] *= gains[static_cast<size_t> (lane)];
+
+        for (int section = 0; section < numSections; ++section)
+        {
+            const auto* c = coefficients.data() + static_cast<size_t> (section * numCoefficients * numLanes);
+            const auto* cb0 = c;
+            const auto* cb1 = c + numLanes;
+            const auto* cb2 = c + 2 * numLanes;
+            const auto* ca1 = c + 3 * numLanes;
+            const auto* ca2 = c + 4 * numLanes;
+            auto* s1 = state.data() + static_cast<size_t> (section * 2 * numLanes);
+            auto* s2 = s1 + numLanes;
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const auto in = x[lane];
+                const auto out = cb0[lane] * in + s1[lane];
+                s1[lane] = cb1[lane] * in - ca1[lane] * out + s2[lane];
+                s2[lane] = cb2[lane] * in - ca2[lane] * out;
+                x[lane] = out;
+            }
+        }
+    }
+}
+
+float& ReflectionFilterBank::getCoefficient (int section, Coefficient coefficient, int lane) noexcept
+{
+    return coefficients[static_cast<size_t> ((section * numCoefficients + coefficient) * numLanes + lane)];
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "RoomMaterials.h"
+#include <juce_core/juce_core.h>
+#include <array>
+#include <vector>
+
+// Wall reflection filters, one per lane: a broadband gain and a biquad per
+// octave band, shelves at either end and peaks in between, whose gains are
+// fitted to a surface's octave-band absorption. Cascading reflections adds
+// their gains, so one lane with the summed gains stands in for every wall a
+// reflection met. State and coefficients are stored lanes innermost, so the
+// loop over lanes is plain element-wise arithmetic the compiler vectorises
+// and many reflections filter at once.
+class ReflectionFilterBank final
+{
+public:
+    static constexpr int numSections { RoomMaterials::numBands };
+
+    ReflectionFilterBank() = default;
+
+    // A filter's gains in dB
+    struct Response
+    {
+        float gainDb { 0.0f };
+        std::array<float, numSections> sectionGainsDb {};
+
+        // The response of this filter followed by times more of other
+        void add (const Response& other, float times) noexcept;
+    };
+
+    // Matches the energy a surface of this absorption reflects at every band
+    // centre
+    static Response fit (const RoomMaterials::BandValues& absorption, double sampleRate);
+
+    // One more step of the same fit, towards a target gain in dB per band.
+    // A few from a nearby response converge to within a fraction of a dB
+    static void refine (Response& response, const RoomMaterials::BandValues& targetDb, double sampleRate);
+
+    // The fit for a RoomMaterials::Id, every material's computed once per
+    // rate. Out of range ids give the first material, as RoomMaterials::get()
+    static const Response& getMaterialResponse (int id, double sampleRate);
+
+    static float getMagnitudeDb (const Response& response, double sampleRate, float frequency);
+
+    void prepare (int numLanes, double sampleRate);
+    void setLane (int lane, const Response& response);
+    void reset() noexcept;
+
+    int getNumLanes() const noexcept { return numLanes; }
+
+    // Filters numFrames frames of getNumLanes() interleaved samples in place
+    void process (float* frames, int numFrames) noexcept;
+
+private:
+    enum Coefficient { b0, b1, b2, a1, a2, numCoefficients };
+
+    float& getCoefficient (int section, Coefficient coefficient, int lane) noexcept;
+
+    std::vector<float> coefficients; // [section][coefficient][lane], a0 normalised out
+    std::vector<float> gains;        // [lane]
+    std::vector<float> state;        // [section][2][lane], transposed direct form II
+    int numLanes { 0 };
+    double sampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReflectionFilterBank)
+};
@@ -0,0 +1,414 @@
+#include "ReverbEngine.h"
+
+ReverbEngine::ReverbEngine (DelayStorage storageToUse) : storage (storageToUse)
+{
+    for (size_t ch = 0; ch < maxChannels; ++ch)
+    {
+        tailPointers[ch] = reducedTail[ch].data();
+        outputPointers[ch] = tailOutput[ch].data();
+        reflectionPointers[ch] = reflectionBlocks[ch].data();
+    }
+
+    setParameters (Parameters());
+    allocateLines (ProcessingLimits::maxSampleRate, ProcessingLimits::preallocatedChannels);
+    prepare (44100.0, ProcessingLimits::preallocatedChannels, ProcessingLimits::preallocatedChannels);
+}
+
+bool ReverbEngine::isLayoutSupported (int numInputChannels, int numOutputChannels) noexcept
+{
+    if (numInputChannels == 1 && numOutputChannels == 2)
+        return true;
+
+    return numInputChannels == numOutputChannels
+        && std::find (std::begin (SimdKernels::combBankChannelCounts), std::end (SimdKernels::combBankChannelCounts), numOutputChannels)
+               != std::end (SimdKernels::combBankChannelCounts);
+}
+
+void ReverbEngine::allocateLines (double capacitySampleRate, int capacityChannels)
+{
+    std::vector<size_t> lineSizes;
+
+    for (int i = 0; i < Freeverb::numCombs; ++i)
+        for (int ch = 0; ch < capacityChannels; ++ch)
+            lineSizes.push_back (static_cast<size_t> (Freeverb::getLineLength (capacitySampleRate, Freeverb::combTunings[i], ch))
+                                 * getBytesPerSample (storage));
+
+    for (int i = 0; i < Freeverb::numAllPasses; ++i)
+        for (int ch = 0; ch < capacityChannels; ++ch)
+            lineSizes.push_back (static_cast<size_t> (Freeverb::getLineLength (capacitySampleRate, Freeverb::allPassTunings[i], ch))
+                                 * getBytesPerSample (storage));
+
+    arena.allocate (lineSizes);
+    reflections.allocate (capacitySampleRate, TailResampler::maxBlockSize);
+    arenaSampleRate = capacitySampleRate;
+    arenaChannels = capacityChannels;
+}
+
+template <size_t Index>
+void ReverbEngine::emplaceNetwork (int numInputChannels, int numOutputChannels) noexcept
+{
+    if constexpr (Index < std::variant_size_v<Network>)
+    {
+        using Alternative = std::variant_alternative_t<Index, Network>;
+
+        if (Alternative::numInputChannels == numInputChannels && Alternative::numChannels == numOutputChannels)
+            network.emplace<Index>();
+        else
+            emplaceNetwork<Index + 1> (numInputChannels, numOutputChannels);
+    }
+}
+
+void ReverbEngine::prepare (double sampleRate, int numInputChannels, int numOutputChannels)
+{
+    jassert (sampleRate > 0);
+    jassert (isLayoutSupported (numInputChannels, numOutputChannels));
+
+    if (numInputChannels == 1 && numOutputChannels == 2)
+    {
+        numInputChannelsPrepared = 1;
+        numChannelsPrepared = 2;
+    }
+    else
+    {
+        // The widest specialisation that fits, a stray layout still gets a
+        // reverb on its first channels
+        numChannelsPrepared = 1;
+
+        for (auto count : SimdKernels::combBankChannelCounts)
+            if (count <= juce::jmin (numInputChannels, numOutputChannels))
+                numChannelsPrepared = count;
+
+        numInputChannelsPrepared = numChannelsPrepared;
+    }
+
+    if (sampleRate > arenaSampleRate || numChannelsPrepared > arenaChannels)
+        allocateLines (juce::jmax (sampleRate, arenaSampleRate), juce::jmax (numChannelsPrepared, arenaChannels));
+
+    preparedSampleRate = sampleRate;
+
+    // The first call ran the CPU detection and self-test from the constructor
+    kernels = &SimdKernels::getBest();
+
+    const auto factor = getTailFactor (sampleRate, tailRate);
+    const auto networkRate = sampleRate / factor;
+    tailResampler.setFactor (factor);
+    reflections.prepare (sampleRate, numChannelsPrepared);
+
+    emplaceNetwork (numInputChannelsPrepared, numChannelsPrepared);
+    std::visit ([&] (auto& n) { n.prepare (arena, arenaChannels, static_cast<int> (getBytesPerSample (storage)), networkRate); },
+                network);
+
+    reset();
+    numSettledCoefficients = 0;
+    networkHasDecay = false;
+
+    const double smoothTime = 0.01;
+    damping.reset (networkRate, smoothTime);
+    feedback.reset (networkRate, smoothTime);
+    reflectionGain.reset (sampleRate, smoothTime);
+    dryGain.reset (sampleRate, smoothTime);
+    wetGain1.reset (sampleRate, smoothTime);
+    wetGain2.reset (sampleRate, smoothTime);
+}
+
+int ReverbEngine::getTailFactor (double sampleRate, TailRate rate) noexcept
+{
+    // The reduced tail rate stays at or above 44.1 kHz
+    return rate == TailRate::full ? 1 : sampleRate >= 176400.0 ? 4 : sampleRate >= 88200.0 ? 2 : 1;
+}
+
+void ReverbEngine::setTailRate (TailRate newTailRate) noexcept
+{
+    if (newTailRate == tailRate)
+        return;
+
+    tailRate = newTailRate;
+    prepare (preparedSampleRate, numInputChannelsPrepared, numChannelsPrepared);
+}
+
+void ReverbEngine::reset() noexcept
+{
+    tailResampler.reset();
+    reflections.reset();
+    std::visit ([this] (auto& n) { n.reset (static_cast<int> (getBytesPerSample (storage))); }, network);
+}
+
+void ReverbEngine::setParameters (const Parameters& newParams) noexcept
+{
+    const float wetScaleFactor = 3.0f;
+    const float dryScaleFactor = 2.0f;
+
+    const float wet = newParams.wetLevel * wetScaleFactor;
+    dryGain.setTargetValue (newParams.dryLevel * dryScaleFactor);
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + newParams.width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - newParams.width));
+
+    gain = isFrozen (newParams.freezeMode) ? 0.0f : fixedGain;
+    parameters = newParams;
+    updateDamping();
+}
+
+void ReverbEngine::setMultibandDecay (std::optional<MultibandDecay> newDecay, double sampleRate)
+{
+    if (! newDecay.has_value())
+    {
+        const juce::SpinLock::ScopedLockType sl (decayLock);
+        pendingDecay.enabled = false;
+        pendingDecay.sampleRate = sampleRate;
+        hasPendingDecay = true;
+        return;
+    }
+
+    // Too large for the stack of whichever thread calls this
+    auto design = std::make_unique<DecayDesign>();
+    design->enabled = true;
+    design->sampleRate = sampleRate;
+
+    for (const auto rate : { TailRate::full, TailRate::reduced })
+    {
+        const auto networkRate = sampleRate / getTailFactor (sampleRate, rate);
+        int32_t lineSizes[SimdKernels::CombBank::maxLanes] {};
+
+        for (int ch = 0; ch < maxChannels; ++ch)
+            for (int i = 0; i < Freeverb::numCombs; ++i)
+                lineSizes[ch * Freeverb::numCombs + i] = Freeverb::getLineLength (networkRate, Freeverb::combTunings[i], ch);
+
+        newDecay->design (networkRate, lineSizes, maxChannels * Freeverb::numCombs, design->filters[rate == TailRate::full ? 0 : 1]);
+    }
+
+    const juce::SpinLock::ScopedLockType sl (decayLock);
+    pendingDecay = *design;
+    hasPendingDecay = true;
+}
+
+bool ReverbEngine::prepareDecay() noexcept
+{
+    if (const juce::SpinLock::ScopedTryLockType sl (decayLock); sl.isLocked() && hasPendingDecay)
+    {
+        decay = pendingDecay;
+        hasPendingDecay = false;
+        networkHasDecay = false;
+    }
+
+    if (! decay.enabled || ! juce::exactlyEqual (decay.sampleRate, preparedSampleRate) || isFrozen (parameters.freezeMode))
+        return false;
+
+    if (! networkHasDecay)
+    {
+        const auto& filters = decay.filters[tailResampler.getFactor() > 1 ? 1 : 0];
+        std::visit ([&] (auto& n) { n.setDecayFilters (filters); }, network);
+        networkHasDecay = true;
+    }
+
+    return true;
+}
+
+void ReverbEngine::setReflectionLevel (float newLevel) noexcept
+{
+    reflectionGain.setTargetValue (newLevel);
+}
+
+void ReverbEngine::updateDamping() noexcept
+{
+    const float roomScaleFactor = 0.28f;
+    const float roomOffset = 0.7f;
+    const float dampScaleFactor = 0.4f;
+
+    if (isFrozen (parameters.freezeMode))
+    {
+        damping.setTargetValue (0.0f);
+        feedback.setTargetValue (1.0f);
+    }
+    else
+    {
+        damping.setTargetValue (parameters.damping * dampScaleFactor);
+        feedback.setTargetValue (parameters.roomSize * roomScaleFactor + roomOffset);
+    }
+}
+
+void ReverbEngine::process (juce::AudioBuffer<float>& buffer, int numSamples) noexcept
+{
+    jassert (buffer.getNumChannels() >= numChannelsPrepared);
+
+    if (buffer.getNumChannels() >= numChannelsPrepared)
+        process (buffer.getArrayOfWritePointers(), numSamples);
+}
+
+void ReverbEngine::process (float* const* channels, int numSamples) noexcept
+{
+    const auto withDecay = prepareDecay();
+
+    std::visit (
+        [&] (auto& n)
+        {
+            switch (storage)
+            {
+                case DelayStorage::float32:  render<Float32Sample> (n, channels, numSamples, withDecay); break;
+                case DelayStorage::float16:  render<Float16Sample> (n, channels, numSamples, withDecay); break;
+                case DelayStorage::bfloat16: render<BFloat16Sample> (n, channels, numSamples, withDecay); break;
+            }
+        },
+        network);
+}
+
+template <typename Format, typename NetworkType>
+void ReverbEngine::render (NetworkType& reverbNetwork, float* const* channels, int numSamples, bool withDecay) noexcept
+{
+    constexpr int numInputChannels { NetworkType::numInputChannels };
+    constexpr int numChannels { NetworkType::numChannels };
+
+    // Summing more channels into the network would raise its level, so the
+    // input is scaled to what a stereo pair feeds it. A mono input to stereo
+    // is fed like the same signal on both sides
+    const auto inputGain = numChannels > 1 ? gain * (2.0f / static_cast<float> (numInputChannels)) : gain;
+
+    auto* input = tailInput.data();
+    float* const* tails = tailPointers.data();
+    float* const* outputs = outputPointers.data();
+    const auto decimated = tailResampler.getFactor() > 1;
+
+    for (int start = 0; start < numSamples; start += TailResampler::maxBlockSize)
+    {
+        const auto blockSize = juce::jmin (TailResampler::maxBlockSize, numSamples - start);
+
+        for (int i = 0; i < blockSize; ++i)
+        {
+            float sum = channels[0][start + i];
+
+            for (int ch = 1; ch < numInputChannels; ++ch)
+                sum += channels[ch][start + i];
+
+            input[i] = sum * inputGain;
+        }
+
+        // The reflections are taken at the host rate, and the combs fed
+        // their sum along with the input
+        const auto withReflections = addReflections<numChannels> (input, blockSize);
+        const auto numReduced = decimated ? tailResampler.decimate (input, blockSize, input) : blockSize;
+
+        if (withDecay)
+        {
+            reverbNetwork.template processDecay<Format> (*kernels, input, tails, numReduced);
+        }
+        else
+        {
+            // Once settled the coefficient blocks hold the same value
+            // throughout, so they are only written again after a change or
+            // for a longer block
+            const auto settled = ! damping.isSmoothing() && ! feedback.isSmoothing();
+
+            if (! settled || numReduced > numSettledCoefficients)
+            {
+                for (int i = 0; i < numReduced; ++i)
+                {
+                    dampingBlock[static_cast<size_t> (i)] = damping.getNextValue();
+                    feedbackBlock[static_cast<size_t> (i)] = feedback.getNextValue();
+                }
+
+                numSettledCoefficients = settled ? numReduced : 0;
+            }
+
+            reverbNetwork.template process<Format> (*kernels, input, dampingBlock.data(), feedbackBlock.data(), tails, numReduced);
+        }
+
+        if (decimated)
+            tailResampler.interpolate (tails, numReduced, outputs, numChannels, blockSize);
+
+        float* const* wet = decimated ? outputs : tails;
+
+        if (withReflections)
+            for (int ch = 0; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::add (wet[ch], reflectionPointers[static_cast<size_t> (ch)], blockSize);
+
+        // With the dry level settled at zero the wet signal is written over
+        // the input rather than added to a scaled copy of it
+        if (! dryGain.isSmoothing() && juce::approximatelyEqual (dryGain.getTargetValue(), 0.0f))
+            mix<numChannels, false> (wet, channels, start, blockSize);
+        else
+            mix<numChannels, true> (wet, channels, start, blockSize);
+    }
+}
+
+template <int Channels>
+bool ReverbEngine::addReflections (float* input, int numSamples) noexcept
+{
+    if (! reflectionGain.isSmoothing() && juce::approximatelyEqual (reflectionGain.getTargetValue(), 0.0f))
+    {
+        reflectionsActive = false;
+        return false;
+    }
+
+    // What was fed in while they were skipped has no reflections to give
+    if (! reflectionsActive)
+    {
+        reflections.reset();
+        reflectionsActive = true;
+    }
+
+    reflections.process (*kernels, input, reflectionPointers.data(), numSamples);
+
+    // The input is scaled down for the combs, so the reflections are brought
+    // back up, to about the level of the first 300 ms of a mid-sized tail at
+    // full level. The combs then take their mean along with the input, so
+    // the tail builds up from them
+    const auto outputScale = 0.5f / fixedGain;
+    const auto feedScale = 1.0f / static_cast<float> (Channels);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto level = reflectionGain.getNextValue();
+        float sum = 0.0f;
+
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            auto& sample = reflectionBlocks[static_cast<size_t> (ch)][static_cast<size_t> (i)];
+            sum += sample;
+            sample *= level * outputScale;
+        }
+
+        input[i] += level * feedScale * sum;
+    }
+
+    return true;
+}
+
+template <int Channels, bool WithDry>
+void ReverbEngine::mix (const float* const* wet, float* const* channels, int start, int numSamples) noexcept
+{
+    auto mixSample = [&] (int i, float dry, float wet1, float wet2)
+    {
+        if constexpr (Channels == 1)
+        {
+            auto& sample = channels[0][start + i];
+            sample = WithDry ? wet[0][i] * wet1 + sample * dry : wet[0][i] * wet1;
+        }
+        else
+        {
+            // Pairs cross-mix for width, a trailing odd channel mixes with
+            // itself
+            for (int ch = 0; ch < Channels; ++ch)
+            {
+                const auto partner = juce::jmin (ch ^ 1, Channels - 1);
+                auto& sample = channels[ch][start + i];
+                const auto wetSample = wet[ch][i] * wet1 + wet[partner][i] * wet2;
+                sample = WithDry ? wetSample + sample * dry : wetSample;
+            }
+        }
+    };
+
+    // Settled gains are read once rather than stepped every sample
+    if (! dryGain.isSmoothing() && ! wetGain1.isSmoothing() && ! wetGain2.isSmoothing())
+    {
+        const auto dry = dryGain.getTargetValue();
+        const auto wet1 = wetGain1.getTargetValue();
+        const auto wet2 = wetGain2.getTargetValue();
+
+        for (int i = 0; i < numSamples; ++i)
+            mixSample (i, dry, wet1, wet2);
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+            mixSample (i, WithDry ? dryGain.getNextValue() : 0.0f, wetGain1.getNextValue(), wetGain2.getNextValue());
+    }
+}
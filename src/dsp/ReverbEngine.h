@@ -0,0 +1,174 @@
+#pragma once
+
+#include "DelayArena.h"
+#include "DelaySample.h"
+#include "MultibandDecay.h"
+#include "ProcessingLimits.h"
+#include "ReverbNetwork.h"
+#include "SimdKernels.h"
+#include "TailResampler.h"
+#include "VelvetDecorrelator.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <optional>
+#include <variant>
+
+// FreeVerb-style reverb with the same tunings, parameter mapping and output
+// staging as juce::Reverb, but with all comb and allpass lines living in a
+// single DelayArena. The arena is sized for ProcessingLimits::maxSampleRate
+// and ProcessingLimits::preallocatedChannels on construction; prepare() only
+// re-indexes into it, so it is bounded-time and allocation-free for every
+// rate up to that limit.
+class ReverbEngine final
+{
+public:
+    using Parameters = juce::Reverb::Parameters;
+
+    // With reduced the comb/allpass network runs at 1/2 or 1/4 of the host
+    // rate, whichever keeps it at or above 44.1 kHz, behind halfband
+    // decimation and interpolation. The input gain, the early reflections
+    // and the output mix stay at the host rate
+    enum class TailRate
+    {
+        full,
+        reduced
+    };
+
+    static constexpr int maxChannels { ProcessingLimits::maxChannels };
+
+    explicit ReverbEngine (DelayStorage storageToUse = defaultDelayStorage);
+
+    // True for the layouts there is a network specialisation for: mono,
+    // stereo, quad, 5.1 and 7.1.4, and mono in to stereo out through a
+    // MonoToStereoNetwork
+    static bool isLayoutSupported (int numInputChannels, int numOutputChannels) noexcept;
+
+    // Only allocates if sampleRate or the channel count exceed what the arena
+    // was sized for. Unsupported layouts run the widest network that fits.
+    // With a mono input, process() reads it from the first channel only
+    void prepare (double sampleRate, int numInputChannels, int numOutputChannels);
+    void reset() noexcept;
+
+    // Re-prepares and clears the tail if the rate changes. Allocation-free,
+    // so it may be called between blocks on the audio thread
+    void setTailRate (TailRate newTailRate) noexcept;
+    TailRate getTailRate() const noexcept { return tailRate; }
+
+    void setParameters (const Parameters& newParams) noexcept;
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    // Any thread but the audio thread. Designs the comb filters for both tail
+    // rates at sampleRate, the rate the engine is or is about to be prepared
+    // for, and queues them for the next block. The combs then decay at the
+    // design's time per band, and the room size and damping go unused;
+    // freezing still holds the tail. nullopt goes back to the room size and
+    // damping, without allocating. A design for another rate is held until
+    // prepare() brings the engine to it
+    void setMultibandDecay (std::optional<MultibandDecay> decay, double sampleRate);
+
+    // Level of the early reflections relative to the input, 0 for none.
+    // They come from a VelvetDecorrelator, different on every channel, and
+    // are mixed into the wet signal ahead of the tail, which is fed them
+    // along with the input. At zero they cost nothing. Real-time safe
+    void setReflectionLevel (float newLevel) noexcept;
+
+    int getNumChannels() const noexcept { return numChannelsPrepared; }
+
+    // Processes the first getNumChannels() channels of the buffer in place.
+    // Per sample, blocks of under 16 samples cost up to about 4x what long
+    // ones do, since each call loads and stores every line's state once.
+    // Through PluginProcessor::processBlock the plug-in as a whole costs
+    // about twice the engine per sample, and single samples about 4x to 6x
+    // what long blocks do; bench/ReverbEngineBench.cpp measures both
+    void process (juce::AudioBuffer<float>& buffer, int numSamples) noexcept;
+    void process (float* const* channels, int numSamples) noexcept;
+
+    DelayStorage getDelayStorage() const noexcept { return storage; }
+
+private:
+    // One alternative per entry of SimdKernels::combBankChannelCounts, plus
+    // mono to stereo
+    using Network = std::variant<ReverbNetwork<1, Freeverb::numCombs>,
+                                 ReverbNetwork<2, Freeverb::numCombs>,
+                                 ReverbNetwork<4, Freeverb::numCombs>,
+                                 ReverbNetwork<6, Freeverb::numCombs>,
+                                 ReverbNetwork<12, Freeverb::numCombs>,
+                                 MonoToStereoNetwork<Freeverb::numCombs>>;
+
+    // The comb filters of every line the arena can hold, lane
+    // ch * Freeverb::numCombs + comb, for the full and the reduced tail rate
+    struct DecayDesign
+    {
+        bool enabled { false };
+        double sampleRate {};
+        SimdKernels::CombBank::DecayFilters filters[2];
+    };
+
+    // What juce::Reverb scales its input by before the combs
+    static constexpr float fixedGain { 0.015f };
+
+    static bool isFrozen (float freezeMode) noexcept { return freezeMode >= 0.5f; }
+    static int getTailFactor (double sampleRate, TailRate rate) noexcept;
+    void updateDamping() noexcept;
+
+    // Whether this block runs the decay filters, loading them into the
+    // network first if they are new to it
+    bool prepareDecay() noexcept;
+
+    template <size_t Index = 0>
+    void emplaceNetwork (int numInputChannels, int numOutputChannels) noexcept;
+
+    template <typename Format, typename NetworkType>
+    void render (NetworkType& reverbNetwork, float* const* channels, int numSamples, bool withDecay) noexcept;
+
+    // Writes the reflections of the host-rate input to the reflection blocks
+    // and adds them to the input, scaled. False, without touching either,
+    // while the level is settled at zero
+    template <int Channels>
+    bool addReflections (float* input, int numSamples) noexcept;
+
+    // Channels are paired in bus order (L/R, C/LFE, Ls/Rs, ...) for the width
+    // cross-mix
+    template <int Channels, bool WithDry>
+    void mix (const float* const* wet, float* const* channels, int start, int numSamples) noexcept;
+
+    void allocateLines (double capacitySampleRate, int capacityChannels);
+
+    const DelayStorage storage;
+    DelayArena arena;
+    double arenaSampleRate {};
+    int arenaChannels {};
+    Network network;
+    // The variant picked for this CPU, which the network runs through a block
+    // at a time. The 16-bit formats use the scalar kernels
+    const SimdKernels::Table* kernels { nullptr };
+    int numInputChannelsPrepared {};
+    int numChannelsPrepared {};
+    double preparedSampleRate {};
+
+    TailRate tailRate { TailRate::full };
+    TailResampler tailResampler;
+
+    // Scratch for one block of the network, at most one resampler block
+    using TailBlock = std::array<float, TailResampler::maxBlockSize>;
+    TailBlock tailInput {}, dampingBlock {}, feedbackBlock {};
+    std::array<TailBlock, maxChannels> reducedTail {}, tailOutput {}, reflectionBlocks {};
+    std::array<float*, maxChannels> tailPointers {}, outputPointers {}, reflectionPointers {};
+
+    // Leading entries of dampingBlock/feedbackBlock that hold the settled
+    // coefficients, so tiny blocks don't rewrite them on every call
+    int numSettledCoefficients {};
+
+    juce::SpinLock decayLock;
+    DecayDesign pendingDecay, decay;
+    bool hasPendingDecay { false }; // guarded by decayLock
+    bool networkHasDecay { false }; // whether the network holds decay's filters for its rate
+
+    VelvetDecorrelator reflections;
+    bool reflectionsActive { false }; // false while skipped, the history is stale then
+
+    Parameters parameters;
+    float gain {};
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2, reflectionGain;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverbEngine)
+};
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "DelayArena.h"
+#include "ScalarKernels.h"
+#include "SimdKernels.h"
+#include <type_traits>
+
+// Freeverb's line tunings and where each line lives in a reverb's arena.
+// Lines are ordered the way they are touched per sample: every comb of every
+// channel, then the allpass chains.
+namespace Freeverb
+{
+
+inline constexpr int numCombs { 8 };
+inline constexpr int numAllPasses { 4 };
+inline constexpr short combTunings[numCombs] { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 }; // (at 44100Hz)
+inline constexpr short allPassTunings[numAllPasses] { 556, 441, 341, 225 };
+inline constexpr int stereoSpread { 23 };
+
+inline int getLineLength (double sampleRate, int tuning, int channel)
+{
+    return (static_cast<int> (sampleRate) * (tuning + channel * stereoSpread)) / 44100;
+}
+
+inline int getCombLine (int comb, int channel, int arenaChannels) { return comb * arenaChannels + channel; }
+
+inline int getAllPassLine (int allPass, int channel, int arenaChannels)
+{
+    return (numCombs + allPass) * arenaChannels + channel;
+}
+
+inline void copyDecayFilter (const SimdKernels::CombBank::DecayFilters& source,
+                             int sourceLane,
+                             SimdKernels::CombBank::DecayFilters& destination,
+                             int destinationLane) noexcept
+{
+    destination.b0[destinationLane] = source.b0[sourceLane];
+    destination.b1[destinationLane] = source.b1[sourceLane];
+    destination.b2[destinationLane] = source.b2[sourceLane];
+    destination.a1[destinationLane] = source.a1[sourceLane];
+    destination.a2[destinationLane] = source.a2[sourceLane];
+}
+
+// Blocks shorter than this go through each allpass chain a sample at a
+// time, where the block-wise kernels would spend more on setup than on work
+inline constexpr int minBlockWiseAllPass { 4 };
+
+template <typename Format, size_t Channels>
+void processAllPasses (const SimdKernels::Table& kernels,
+                       SimdKernels::AllPass (&allPass)[Channels][numAllPasses],
+                       float* const* outputs,
+                       int numSamples) noexcept
+{
+    for (size_t ch = 0; ch < Channels; ++ch)
+    {
+        if (numSamples < minBlockWiseAllPass)
+            ScalarKernels::allPassChain<Format> (allPass[ch], outputs[ch], numSamples);
+        else if constexpr (std::is_same_v<Format, Float32Sample>)
+            for (auto& a : allPass[ch])
+                kernels.allPass (a, outputs[ch], numSamples);
+        else
+            for (auto& a : allPass[ch])
+                ScalarKernels::allPass<Format> (a, outputs[ch], numSamples);
+    }
+}
+
+} // namespace Freeverb
+
+// The comb/allpass network for a fixed channel count and number of combs per
+// channel. Every loop over channels and lines has a compile-time trip count,
+// so nothing on the audio path branches on the layout. Channel ch runs the
+// same tunings spread by ch * stereoSpread samples, which for stereo is
+// exactly juce::Reverb's network.
+template <int Channels, int Lines>
+class ReverbNetwork final
+{
+public:
+    static constexpr int numInputChannels { Channels };
+    static constexpr int numChannels { Channels };
+    static constexpr int numCombs { Lines };
+
+    static_assert (Channels >= 1 && Channels <= ProcessingLimits::maxChannels);
+    static_assert (Lines >= 1 && Lines <= Freeverb::numCombs && Freeverb::numCombs <= SimdKernels::CombBank::maxLinesPerChannel);
+
+    // Points every line at its slot in an arena laid out for arenaChannels,
+    // using only as much of it as this rate needs
+    void prepare (const DelayArena& arena, int arenaChannels, int bytesPerSample, double sampleRate) noexcept
+    {
+        jassert (arenaChannels >= Channels);
+
+        const auto* base = arena.getLine<char> (0);
+        combBank.base = arena.getLine<char> (0);
+
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            for (int i = 0; i < Lines; ++i)
+            {
+                const auto line = Freeverb::getCombLine (i, ch, arenaChannels);
+                combBank.offsets[ch * Lines + i] = static_cast<int32_t> (arena.getLine<char> (line) - base) / bytesPerSample;
+                combBank.sizes[ch * Lines + i] = Freeverb::getLineLength (sampleRate, Freeverb::combTunings[i], ch);
+            }
+
+            for (int i = 0; i < Freeverb::numAllPasses; ++i)
+                allPass[ch][i] = { arena.getLine<void> (Freeverb::getAllPassLine (i, ch, arenaChannels)),
+                                   Freeverb::getLineLength (sampleRate, Freeverb::allPassTunings[i], ch) };
+        }
+    }
+
+    void reset (int bytesPerSample) noexcept
+    {
+        for (int lane = 0; lane < Channels * Lines; ++lane)
+        {
+            std::memset (static_cast<char*> (combBank.base) + combBank.offsets[lane] * bytesPerSample,
+                         0,
+                         static_cast<size_t> (combBank.sizes[lane] * bytesPerSample));
+            combBank.indices[lane] = 0;
+            combBank.last[lane] = 0.0f;
+            combBank.decayState1[lane] = 0.0f;
+            combBank.decayState2[lane] = 0.0f;
+        }
+
+        for (auto& chain : allPass)
+        {
+            for (auto& a : chain)
+            {
+                std::memset (a.buffer, 0, static_cast<size_t> (a.size * bytesPerSample));
+                a.index = 0;
+            }
+        }
+    }
+
+    // Accumulates the comb filters in parallel, then runs the allpass filters
+    // in series. Each allpass only depends on its own past, so running them
+    // one block after another gives the same result as interleaving them per
+    // sample
+    template <typename Format>
+    void process (const SimdKernels::Table& kernels,
+                  const float* input,
+                  const float* damping,
+                  const float* feedback,
+                  float* const* outputs,
+                  int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<Format, Float32Sample> && Lines == SimdKernels::CombBank::maxLinesPerChannel)
+        {
+            if (auto* combBankKernel = kernels.combBanks[Channels])
+            {
+                combBankKernel (combBank, input, damping, feedback, outputs, numSamples);
+                Freeverb::processAllPasses<Format> (kernels, allPass, outputs, numSamples);
+                return;
+            }
+        }
+
+        ScalarKernels::combBank<Format, Channels, Lines> (combBank, input, damping, feedback, outputs, numSamples);
+        Freeverb::processAllPasses<Format> (kernels, allPass, outputs, numSamples);
+    }
+
+    // Takes channel ch's comb i from lane ch * Freeverb::numCombs + i
+    void setDecayFilters (const SimdKernels::CombBank::DecayFilters& filters) noexcept
+    {
+        for (int ch = 0; ch < Channels; ++ch)
+            for (int i = 0; i < Lines; ++i)
+                Freeverb::copyDecayFilter (filters, ch * Freeverb::numCombs + i, combBank.decay, ch * Lines + i);
+    }
+
+    // process() with every comb fed back through its decay filter
+    template <typename Format>
+    void processDecay (const SimdKernels::Table& kernels, const float* input, float* const* outputs, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<Format, Float32Sample> && Lines == SimdKernels::CombBank::maxLinesPerChannel)
+        {
+            if (auto* combBankKernel = kernels.decayCombBanks[Channels])
+            {
+                combBankKernel (combBank, input, outputs, numSamples);
+                Freeverb::processAllPasses<Format> (kernels, allPass, outputs, numSamples);
+                return;
+            }
+        }
+
+        ScalarKernels::decayCombBank<Format, Channels, Lines> (combBank, input, outputs, numSamples);
+        Freeverb::processAllPasses<Format> (kernels, allPass, outputs, numSamples);
+    }
+
+private:
+    SimdKernels::CombBank combBank;
+    SimdKernels::AllPass allPass[static_cast<size_t> (Channels)][Freeverb::numAllPasses];
+};
+
+// Mono in, stereo out from a single bank of combs. Instead of a second bank
+// fed the same signal, the right channel reads every comb line again at a
+// second tap, each a different distance from the output tap, and runs its
+// own allpass chain with the right channel's spread tunings.
+template <int Lines>
+class MonoToStereoNetwork final
+{
+public:
+    static constexpr int numInputChannels { 1 };
+    static constexpr int numChannels { 2 };
+    static constexpr int numCombs { Lines };
+
+    static_assert (Lines >= 1 && Lines <= Freeverb::numCombs && Freeverb::numCombs <= SimdKernels::CombBank::maxLinesPerChannel);
+
+    void prepare (const DelayArena& arena, int arenaChannels, int bytesPerSample, double sampleRate) noexcept
+    {
+        jassert (arenaChannels >= numChannels);
+
+        const auto* base = arena.getLine<char> (0);
+        combBank.base = arena.getLine<char> (0);
+
+        for (int i = 0; i < Lines; ++i)
+        {
+            combBank.offsets[i] = static_cast<int32_t> (arena.getLine<char> (Freeverb::getCombLine (i, 0, arenaChannels)) - base) / bytesPerSample;
+            combBank.sizes[i] = Freeverb::getLineLength (sampleRate, Freeverb::combTunings[i], 0);
+
+            // Spread the second taps like the stereo network spreads its lines
+            combBank.taps[i] = juce::jlimit (1, combBank.sizes[i] - 1, Freeverb::getLineLength (sampleRate, (i + 1) * Freeverb::stereoSpread, 0));
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < Freeverb::numAllPasses; ++i)
+                allPass[ch][i] = { arena.getLine<void> (Freeverb::getAllPassLine (i, ch, arenaChannels)),
+                                   Freeverb::getLineLength (sampleRate, Freeverb::allPassTunings[i], ch) };
+    }
+
+    void reset (int bytesPerSample) noexcept
+    {
+        for (int lane = 0; lane < Lines; ++lane)
+        {
+            std::memset (static_cast<char*> (combBank.base) + combBank.offsets[lane] * bytesPerSample,
+                         0,
+                         static_cast<size_t> (combBank.sizes[lane] * bytesPerSample));
+            combBank.indices[lane] = 0;
+            combBank.last[lane] = 0.0f;
+            combBank.decayState1[lane] = 0.0f;
+            combBank.decayState2[lane] = 0.0f;
+        }
+
+        for (auto& chain : allPass)
+        {
+            for (auto& a : chain)
+            {
+                std::memset (a.buffer, 0, static_cast<size_t> (a.size * bytesPerSample));
+                a.index = 0;
+            }
+        }
+    }
+
+    template <typename Format>
+    void process (const SimdKernels::Table& kernels,
+                  const float* input,
+                  const float* damping,
+                  const float* feedback,
+                  float* const* outputs,
+                  int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<Format, Float32Sample> && Lines == SimdKernels::CombBank::maxLinesPerChannel)
+            kernels.monoToStereoCombBank (combBank, input, damping, feedback, outputs, numSamples);
+        else
+            ScalarKernels::monoToStereoCombBank<Format, Lines> (combBank, input, damping, feedback, outputs, numSamples);
+
+        Freeverb::processAllPasses<Format> (kernels, allPass, outputs, numSamples);
+    }
+
+    // The combs are channel 0's, so take lanes [0, Lines)
+    void setDecayFilters (const SimdKernels::CombBank::DecayFilters& filters) noexcept
+    {
+        for (int i = 0; i < Lines; ++i)
+            Freeverb::copyDecayFilter (filters, i, combBank.decay, i);
+    }
+
+    template <typename Format>
+    void processDecay (const SimdKernels::Table& kernels, const float* input, float* const* outputs, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<Format, Float32Sample> && Lines == SimdKernels::CombBank::maxLinesPerChannel)
+            kernels.decayMonoToStereoCombBank (combBank, input, outputs, numSamples);
+        else
+            ScalarKernels::decayMonoToStereoCombBank<Format, Lines> (combBank, input, outputs, numSamples);
+
+        Freeverb::processAllPasses<Format> (kernels, allPass, outputs, numSamples);
+    }
+
+private:
+    SimdKernels::CombBank combBank;
+    SimdKernels::AllPass allPass[numChannels][Freeverb::numAllPasses];
+};
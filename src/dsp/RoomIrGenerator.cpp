@@ -0,0 +1,156 @@
+#include "RoomIrGenerator.h"
+#include "IrPreparation.h"
+#include "ProcessingLimits.h"
+#include "RoomIrSynthesis.h"
+#include "RoomRayTracer.h"
+#include <juce_cryptography/juce_cryptography.h>
+#include <algorithm>
+#include <array>
+
+namespace
+{
+
+constexpr size_t numRecentRooms { 8 };
+
+// Rays traced in total after each pass. The first takes a few milliseconds
+constexpr std::array<int, 3> rayPasses { 2000, 8000, 32000 };
+
+// The tracer may run for this much longer than the longest Eyring
+// reverberation time, as rooms with uneven absorption decay slower than it
+// says. Rays usually fade out well before
+constexpr float tracedDecayHeadroom { 3.0f };
+
+} // namespace
+
+RoomIrGenerator::SharedThreadPool::SharedThreadPool()
+    : pool (juce::ThreadPoolOptions {}
+                .withThreadName ("Room IR synthesis")
+                .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumCpus() - 1)))
+{
+}
+
+RoomIrGenerator::RoomIrGenerator (IrCache& cacheToUse, ConvolutionEngine& engineToFeed)
+    : juce::Thread ("Room IR generator")
+    , cache (cacheToUse)
+    , engine (engineToFeed)
+{
+    startThread (juce::Thread::Priority::background);
+}
+
+RoomIrGenerator::~RoomIrGenerator()
+{
+    // The synthesis checks for the exit signal between passes, so this only
+    // waits for the pool's jobs in flight
+    stopThread (-1);
+}
+
+void RoomIrGenerator::request (const Request& newRequest)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        wanted = newRequest;
+    }
+
+    notify();
+}
+
+bool RoomIrGenerator::isStale (const Request& inProgress)
+{
+    const juce::ScopedLock sl (lock);
+    return ! (wanted == inProgress);
+}
+
+void RoomIrGenerator::run()
+{
+    while (! threadShouldExit())
+    {
+        Request next;
+
+        {
+            const juce::ScopedLock sl (lock);
+            next = wanted;
+        }
+
+        if (next == loaded || next.sampleRate <= 0.0 || next.outputLayout.size() <= 0)
+        {
+            wait (-1);
+            continue;
+        }
+
+        auto shouldAbort = [this, &next] { return threadShouldExit() || isStale (next); };
+
+        // The microphones depend on the output layout and the rays traced on
+        // the passes, so both are part of what the hash identifies
+        const IrCache::Key key { juce::SHA256 ((next.room.getHash() + juce::String (next.outputLayout.size()) + "-"
+                                                + next.outputLayout.getSpeakerArrangementAsString() + "-traced-"
+                                                + juce::String (rayPasses.back())).toUTF8())
+                                     .toHexString(),
+                                 next.sampleRate,
+                                 IrPartitions::defaultPartitionSize,
+                                 {} };
+
+        auto render = [&] (const RoomRayTracer* rayTracer) -> std::unique_ptr<IrPartitions>
+        {
+            auto impulseResponse = RoomIrSynthesis::synthesise (next.room, next.sampleRate, next.outputLayout, threadPool->pool, shouldAbort, rayTracer);
+            const auto numSamples = impulseResponse.getNumSamples();
+
+            if (numSamples == 0)
+                return nullptr;
+
+            IrPreparation::normalise (impulseResponse, numSamples);
+            return std::make_unique<IrPartitions> (impulseResponse, numSamples, key.partitionSize);
+        };
+
+        // A room finished before, in this session or a previous one. Nothing
+        // is computed on a miss
+        auto partitions = cache.acquire (key, [] { return std::unique_ptr<IrPartitions>(); });
+
+        if (partitions == nullptr)
+        {
+            // The statistical response comes first, then ever finer traced
+            // ones; each replaces the last with a crossfade
+            if (auto statistical = render (nullptr))
+                engine.setImpulseResponse (std::shared_ptr<const IrPartitions> (std::move (statistical)), next.numInputChannels, next.outputLayout.size());
+
+            const auto reverbTimes = next.room.getReverbTimes();
+            const auto longest = *std::max_element (reverbTimes.begin(), reverbTimes.end());
+            RoomRayTracer rayTracer (next.room,
+                                     next.outputLayout,
+                                     juce::jmin (ProcessingLimits::maxImpulseResponseSeconds,
+                                                 tracedDecayHeadroom * longest + RoomIrSynthesis::getTransitionTime (next.room)));
+
+            for (auto numRays : rayPasses)
+            {
+                if (shouldAbort() || ! rayTracer.trace (numRays - rayTracer.getNumRays(), threadPool->pool, shouldAbort))
+                    break;
+
+                // Only the last pass is worth keeping
+                if (numRays == rayPasses.back())
+                    partitions = cache.acquire (key, [&] { return render (&rayTracer); });
+                else if (auto coarse = render (&rayTracer))
+                    engine.setImpulseResponse (std::shared_ptr<const IrPartitions> (std::move (coarse)), next.numInputChannels, next.outputLayout.size());
+            }
+        }
+
+        if (threadShouldExit())
+            return;
+
+        // Overtaken: leave the engine alone and start on the newer request
+        if (partitions == nullptr)
+        {
+            if (! isStale (next))
+                loaded = next;
+
+            continue;
+        }
+
+        recent.erase (std::remove (recent.begin(), recent.end(), partitions), recent.end());
+        recent.push_front (partitions);
+
+        if (recent.size() > numRecentRooms)
+            recent.pop_back();
+
+        loaded = next;
+        engine.setImpulseResponse (std::move (partitions), next.numInputChannels, next.outputLayout.size());
+    }
+}
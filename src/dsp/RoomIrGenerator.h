@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ConvolutionEngine.h"
+#include "IrCache.h"
+#include "RoomModel.h"
+#include <juce_core/juce_core.h>
+#include <deque>
+
+// Background thread that synthesises impulse responses for a RoomModel and
+// hands them to a ConvolutionEngine. Like IrLoader it serves only the latest
+// request, but a newer one also aborts a synthesis in progress, so dragging a
+// room dimension doesn't queue up a backlog.
+//
+// Results are progressive: the statistical response goes out first, then
+// responses whose tails follow a RoomRayTracer's histograms over ever more
+// rays. The final one goes through IrCache keyed on the room's hash, and the
+// last few stay referenced so that returning to a recent room is instant.
+class RoomIrGenerator final : private juce::Thread
+{
+public:
+    struct Request
+    {
+        RoomModel room;
+        double sampleRate {};
+        int numInputChannels {};
+        juce::AudioChannelSet outputLayout;
+
+        bool operator== (const Request&) const = default;
+    };
+
+    RoomIrGenerator (IrCache& cacheToUse, ConvolutionEngine& engineToFeed);
+    ~RoomIrGenerator() override;
+
+    // Any thread but the audio thread. Returns immediately; a request equal
+    // to what the engine was last given does nothing
+    void request (const Request& newRequest);
+
+private:
+    // Shared by every instance, one thread per core less the caller's
+    struct SharedThreadPool
+    {
+        SharedThreadPool();
+
+        juce::ThreadPool pool;
+    };
+
+    void run() override;
+    bool isStale (const Request& inProgress);
+
+    IrCache& cache;
+    ConvolutionEngine& engine;
+    juce::SharedResourcePointer<SharedThreadPool> threadPool;
+
+    juce::CriticalSection lock;
+    Request wanted; // guarded by lock
+    Request loaded; // worker thread only
+
+    std::deque<std::shared_ptr<const IrPartitions>> recent; // worker thread only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RoomIrGenerator)
+};
@@ -0,0 +1,411 @@
+#include "RoomIrSynthesis.h"
+#include "ParallelFor.h"
+#include "ProcessingLimits.h"
+#include "ReflectionFilterBank.h"
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace
+{
+
+using Vector = RoomModel::Vector;
+
+constexpr double tailFadeInSeconds { 0.01 };
+constexpr double tailMatchSeconds { 0.03 };
+
+// Long enough for the reflection filters' lowest shelf to ring out
+constexpr double reflectionFilterSeconds { 0.02 };
+constexpr int reflectionFilterRefinements { 2 };
+constexpr int reflectionsPerBatch { 64 };
+
+// Energy a cardioid picks up from a diffuse field, relative to an omni
+constexpr float cardioidDiffuseGain { 1.0f / 3.0f };
+
+struct Microphone
+{
+    Vector position;
+    Vector axis;
+};
+
+struct ImageSource
+{
+    Vector position;
+    float sign;
+    RoomModel::BandValues gain; // reflection loss, in amplitude, times sign
+    std::array<int, RoomModel::numWalls> hits;
+};
+
+// nullopt for a channel without a microphone
+std::vector<std::optional<Microphone>> getMicrophones (const RoomModel& room, const juce::AudioChannelSet& layout)
+{
+    // Spaced a little along their axes, so a stereo pair also differs in time
+    constexpr float spacing { 0.1f };
+
+    const auto listener = room.getListenerPosition();
+    std::vector<std::optional<Microphone>> microphones;
+
+    for (const auto& axis : room.getMicrophoneAxes (layout))
+    {
+        if (axis.has_value())
+            microphones.push_back (Microphone { listener + *axis * spacing, *axis });
+        else
+            microphones.push_back (std::nullopt);
+    }
+
+    return microphones;
+}
+
+// Allen and Berkley's enumeration: along each axis, image k of parity q lies
+// at 2 k L + (1 - 2 q) s and has met the wall at 0 |k - q| times and the wall
+// at L |k| times.
+//
+// Past the first order every image gets a random sign. With all of them
+// positive their low frequencies pile up coherently, far above the level of
+// the incoherent tail that follows, and the regular spacing of the images
+// sweeps audibly in pitch
+std::vector<ImageSource> getImageSources (const RoomModel& room, float maxDistance)
+{
+    const auto source = room.getSourcePosition();
+    const auto listener = room.getListenerPosition();
+    const float sizes[] { room.width, room.length, room.height };
+    const float sourceCoordinates[] { source.x, source.y, source.z };
+
+    RoomModel::BandValues reflection[RoomModel::numWalls];
+
+    for (size_t wall = 0; wall < RoomModel::numWalls; ++wall)
+        for (size_t band = 0; band < RoomModel::numBands; ++band)
+            reflection[wall][band] = std::sqrt (1.0f - juce::jlimit (0.0f, 1.0f, room.getAbsorption (static_cast<int> (wall))[band]));
+
+    int maxOrder[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+        maxOrder[axis] = static_cast<int> (std::ceil (maxDistance / (2.0f * sizes[axis]))) + 1;
+
+    std::vector<ImageSource> images;
+    juce::Random random (0x1a6e5);
+
+    for (int kx = -maxOrder[0]; kx <= maxOrder[0]; ++kx)
+    for (int qx = 0; qx < 2; ++qx)
+    for (int ky = -maxOrder[1]; ky <= maxOrder[1]; ++ky)
+    for (int qy = 0; qy < 2; ++qy)
+    for (int kz = -maxOrder[2]; kz <= maxOrder[2]; ++kz)
+    for (int qz = 0; qz < 2; ++qz)
+    {
+        const int k[] { kx, ky, kz };
+        const int q[] { qx, qy, qz };
+        float coordinates[3];
+        std::array<int, RoomModel::numWalls> hits;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            coordinates[axis] = 2.0f * k[axis] * sizes[axis] + (1 - 2 * q[axis]) * sourceCoordinates[axis];
+            hits[static_cast<size_t> (2 * axis)] = std::abs (k[axis] - q[axis]);
+            hits[static_cast<size_t> (2 * axis + 1)] = std::abs (k[axis]);
+        }
+
+        const Vector position { coordinates[0], coordinates[1], coordinates[2] };
+
+        if ((position - listener).length() > maxDistance)
+            continue;
+
+        const auto order = std::accumulate (hits.begin(), hits.end(), 0);
+        const auto sign = order > 1 && random.nextBool() ? -1.0f : 1.0f;
+
+        ImageSource image { position, sign, {}, hits };
+        image.gain.fill (sign);
+
+        for (size_t wall = 0; wall < RoomModel::numWalls; ++wall)
+            for (size_t band = 0; band < RoomModel::numBands; ++band)
+                image.gain[band] *= std::pow (reflection[wall][band], static_cast<float> (hits[wall]));
+
+        images.push_back (image);
+    }
+
+    return images;
+}
+
+// Every image filtered by the walls it met, as seen by each microphone. One
+// filter bank lane per image: the materials' precomputed responses, summed
+// over the image's reflections, refined towards its exact band gains. Air
+// absorption is left to the tail, it takes under 1.5 dB off the highest
+// band by the transition time
+bool addEarlyReflections (juce::AudioBuffer<float>& impulseResponse,
+                          const RoomModel& room,
+                          const std::vector<ImageSource>& images,
+                          const std::vector<std::optional<Microphone>>& microphones,
+                          double sampleRate,
+                          const std::function<bool()>& shouldAbort)
+{
+    const auto filterLength = juce::roundToInt (reflectionFilterSeconds * sampleRate);
+    const auto numSamples = impulseResponse.getNumSamples();
+
+    std::array<ReflectionFilterBank::Response, RoomModel::numWalls> wallResponses;
+
+    for (size_t wall = 0; wall < RoomModel::numWalls; ++wall)
+        wallResponses[wall] = ReflectionFilterBank::getMaterialResponse (room.materials[wall], sampleRate);
+
+    ReflectionFilterBank bank;
+    bank.prepare (reflectionsPerBatch, sampleRate);
+    std::vector<float> frames (static_cast<size_t> (filterLength * reflectionsPerBatch));
+
+    for (size_t first = 0; first < images.size(); first += reflectionsPerBatch)
+    {
+        if (shouldAbort())
+            return false;
+
+        const auto batchSize = static_cast<int> (juce::jmin (images.size() - first, static_cast<size_t> (reflectionsPerBatch)));
+
+        for (int lane = 0; lane < batchSize; ++lane)
+        {
+            const auto& image = images[first + static_cast<size_t> (lane)];
+            ReflectionFilterBank::Response response;
+            RoomModel::BandValues targetDb;
+
+            for (size_t wall = 0; wall < RoomModel::numWalls; ++wall)
+                response.add (wallResponses[wall], static_cast<float> (image.hits[wall]));
+
+            for (size_t band = 0; band < RoomModel::numBands; ++band)
+                targetDb[band] = juce::Decibels::gainToDecibels (std::abs (image.gain[band]), -300.0f);
+
+            for (int i = 0; i < reflectionFilterRefinements; ++i)
+                ReflectionFilterBank::refine (response, targetDb, sampleRate);
+
+            bank.setLane (lane, response);
+        }
+
+        std::fill (frames.begin(), frames.end(), 0.0f);
+        std::fill (frames.begin(), frames.begin() + reflectionsPerBatch, 1.0f);
+        bank.reset();
+        bank.process (frames.data(), filterLength);
+
+        for (size_t ch = 0; ch < microphones.size(); ++ch)
+        {
+            if (! microphones[ch].has_value())
+                continue;
+
+            auto* output = impulseResponse.getWritePointer (static_cast<int> (ch));
+            const auto& microphone = *microphones[ch];
+
+            for (int lane = 0; lane < batchSize; ++lane)
+            {
+                const auto& image = images[first + static_cast<size_t> (lane)];
+                const auto offset = image.position - microphone.position;
+                const auto distance = juce::jmax (0.1f, offset.length());
+                const auto directivity = 0.5f * (1.0f + microphone.axis.dot (offset) / distance);
+                const auto gain = image.sign * directivity / distance;
+
+                // Linear interpolation, as in the bands
+                const auto position = distance / RoomModel::speedOfSound * static_cast<float> (sampleRate);
+                const auto index = static_cast<int> (position);
+                const auto frac = position - static_cast<float> (index);
+                const auto length = juce::jmin (filterLength, numSamples - 1 - index);
+                const auto* response = frames.data() + lane;
+
+                for (int i = 0; i < length; ++i)
+                {
+                    const auto sample = gain * response[i * reflectionsPerBatch];
+                    output[index + i] += sample * (1.0f - frac);
+                    output[index + i + 1] += sample * frac;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Complementary weights: raised cosines over log frequency between adjacent
+// band centres, so every bin's weights sum to one
+float getBandWeight (int band, float frequency)
+{
+    const auto& centres = RoomModel::bandCentres;
+    const auto last = RoomModel::numBands - 1;
+
+    auto crossfade = [] (float from, float to, float f)
+    {
+        const auto x = juce::jlimit (0.0f, 1.0f, std::log2 (f / from) / std::log2 (to / from));
+        return std::cos (0.5f * juce::MathConstants<float>::pi * x);
+    };
+
+    const auto b = static_cast<size_t> (band);
+    float weight = 1.0f;
+
+    if (band < last && frequency > centres[b])
+        weight = juce::square (crossfade (centres[b], centres[b + 1], frequency));
+
+    if (band > 0 && frequency < centres[b])
+        weight = 1.0f - juce::square (crossfade (centres[b - 1], centres[b], frequency));
+
+    return weight;
+}
+
+float nextGaussian (juce::Random& random)
+{
+    const auto u = juce::jmax (1.0e-12f, random.nextFloat());
+    const auto v = random.nextFloat();
+    return std::sqrt (-2.0f * std::log (u)) * std::cos (juce::MathConstants<float>::twoPi * v);
+}
+
+} // namespace
+
+namespace RoomIrSynthesis
+{
+
+double getTransitionTime (const RoomModel& room)
+{
+    return juce::jlimit (0.03, 0.15, 0.004 * std::sqrt (static_cast<double> (room.getVolume())));
+}
+
+juce::AudioBuffer<float> synthesise (const RoomModel& room,
+                                     double sampleRate,
+                                     const juce::AudioChannelSet& layout,
+                                     juce::ThreadPool& pool,
+                                     const std::function<bool()>& shouldAbort,
+                                     const RoomRayTracer* rayTracer)
+{
+    const auto numChannels = layout.size();
+    jassert (rayTracer == nullptr || rayTracer->getNumChannels() >= numChannels);
+
+    const auto reverbTimes = room.getReverbTimes();
+    const auto transitionTime = getTransitionTime (room);
+    const auto longest = rayTracer != nullptr ? rayTracer->getDecayedLength() * RoomRayTracer::binSeconds
+                                              : static_cast<double> (*std::max_element (reverbTimes.begin(), reverbTimes.end())) + transitionTime;
+    const auto seconds = juce::jmin (longest, ProcessingLimits::maxImpulseResponseSeconds);
+    const auto numSamples = juce::jmax (1, static_cast<int> (std::ceil (seconds * sampleRate)));
+
+    // Padded so the band weights' short ringing doesn't wrap around
+    const auto order = juce::roundToInt (std::ceil (std::log2 (numSamples + 8192)));
+    const auto fftSize = 1 << order;
+    const auto numBins = fftSize / 2 + 1;
+
+    // One per band job: an FFT may lock around each transform, which would
+    // leave the bands waiting on each other
+    std::vector<juce::dsp::FFT> ffts;
+
+    for (int band = 0; band < RoomModel::numBands; ++band)
+        ffts.emplace_back (order);
+
+    const auto microphones = getMicrophones (room, layout);
+    const auto images = getImageSources (room, static_cast<float> (transitionTime) * RoomModel::speedOfSound);
+    const auto& air = RoomModel::getAirAbsorption();
+
+    // Image sources arrive at 4 pi c^3 t^2 / V per second with 1 / (c t)
+    // amplitude, so the reflected energy per second is 4 pi c / V before
+    // absorption, whatever the time. Early on, though, fewer reflections have
+    // taken place than the diffuse decay assumes, which in a dead room leaves
+    // the images far louder than it predicts. So the tail starts at the
+    // images' actual level over the last stretch before the transition and
+    // only decays at the band's reverberation time from there
+    const auto diffuseVariance = 4.0f * juce::MathConstants<float>::pi * RoomModel::speedOfSound
+                               / (room.getVolume() * static_cast<float> (sampleRate)) * cardioidDiffuseGain;
+    const auto fadeStart = juce::jmax (0.0, transitionTime - tailFadeInSeconds);
+    const auto matchStart = static_cast<float> (juce::jmax (0.0, transitionTime - tailMatchSeconds));
+    const auto matchEnd = static_cast<float> (fadeStart);
+
+    juce::AudioBuffer<float> impulseResponse (numChannels, numSamples);
+    std::vector<float> spectrum (static_cast<size_t> (2 * fftSize));
+    juce::CriticalSection spectrumLock;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (shouldAbort())
+            return {};
+
+        if (! microphones[static_cast<size_t> (ch)].has_value())
+        {
+            impulseResponse.clear (ch, 0, numSamples);
+            continue;
+        }
+
+        std::fill (spectrum.begin(), spectrum.end(), 0.0f);
+        const auto& microphone = *microphones[static_cast<size_t> (ch)];
+
+        parallelFor (pool, RoomModel::numBands, [&] (int band)
+        {
+            if (shouldAbort())
+                return;
+
+            const auto b = static_cast<size_t> (band);
+            std::vector<float> signal (static_cast<size_t> (2 * fftSize));
+            float matchedEnergy = 0.0f;
+
+            // The images themselves are added broadband, after the bands,
+            // but the tail starts at their level in this one
+            for (const auto& image : images)
+            {
+                const auto offset = image.position - microphone.position;
+                const auto distance = juce::jmax (0.1f, offset.length());
+                const auto directivity = 0.5f * (1.0f + microphone.axis.dot (offset) / distance);
+                const auto gain = image.gain[b] * std::exp (-0.5f * air[b] * distance) / distance * directivity;
+
+                if (const auto time = distance / RoomModel::speedOfSound; time >= matchStart && time < matchEnd)
+                    matchedEnergy += gain * gain;
+            }
+
+            // Fixed seeds keep the same room sounding the same
+            juce::Random random (0x5eed + 977 * ch + band);
+            const auto matchSamples = (matchEnd - matchStart) * static_cast<float> (sampleRate);
+            const auto decayPerSample = std::pow (10.0f, -3.0f / (reverbTimes[b] * static_cast<float> (sampleRate)));
+            const auto start = static_cast<int> (fadeStart * sampleRate);
+            const auto fadeLength = juce::jmax (1, juce::roundToInt (tailFadeInSeconds * sampleRate));
+            auto envelope = matchedEnergy > 0.0f && matchSamples >= 1.0f
+                              ? std::sqrt (matchedEnergy / matchSamples)
+                              : std::sqrt (diffuseVariance) * std::pow (decayPerSample, static_cast<float> (start));
+
+            // The ray tracer's histogram, interpolated between bin centres,
+            // replaces the exponential decay where there is one
+            const auto samplesPerBin = static_cast<float> (RoomRayTracer::binSeconds * sampleRate);
+
+            auto getTracedEnvelope = [&] (int i)
+            {
+                const auto position = juce::jmax (0.0f, static_cast<float> (i) / samplesPerBin - 0.5f);
+                const auto bin = juce::jmin (rayTracer->getNumBins() - 1, static_cast<int> (position));
+                const auto next = juce::jmin (rayTracer->getNumBins() - 1, bin + 1);
+                const auto frac = position - static_cast<float> (bin);
+                const auto energy = rayTracer->getEnergy (ch, band, bin) * (1.0f - frac) + rayTracer->getEnergy (ch, band, next) * frac;
+                return std::sqrt (energy / samplesPerBin);
+            };
+
+            for (int i = start; i < numSamples; ++i)
+            {
+                const auto fade = i - start < fadeLength
+                                      ? 0.5f - 0.5f * std::cos (juce::MathConstants<float>::pi * static_cast<float> (i - start) / fadeLength)
+                                      : 1.0f;
+                const auto amplitude = rayTracer != nullptr ? getTracedEnvelope (i) : envelope;
+                signal[static_cast<size_t> (i)] += amplitude * fade * nextGaussian (random);
+                envelope *= decayPerSample;
+            }
+
+            ffts[b].performRealOnlyForwardTransform (signal.data(), true);
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                const auto weight = getBandWeight (band, static_cast<float> (k * sampleRate / fftSize));
+                signal[static_cast<size_t> (2 * k)] *= weight;
+                signal[static_cast<size_t> (2 * k + 1)] *= weight;
+            }
+
+            const juce::ScopedLock sl (spectrumLock);
+
+            for (int i = 0; i < 2 * numBins; ++i)
+                spectrum[static_cast<size_t> (i)] += signal[static_cast<size_t> (i)];
+        });
+
+        if (shouldAbort())
+            return {};
+
+        ffts.front().performRealOnlyInverseTransform (spectrum.data());
+        impulseResponse.copyFrom (ch, 0, spectrum.data(), numSamples);
+    }
+
+    if (! addEarlyReflections (impulseResponse, room, images, microphones, sampleRate, shouldAbort))
+        return {};
+
+    return impulseResponse;
+}
+
+} // namespace RoomIrSynthesis
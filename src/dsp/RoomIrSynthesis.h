@@ -0,0 +1,39 @@
+#pragma once
+
+#include "RoomModel.h"
+#include "RoomRayTracer.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <functional>
+
+// Builds an impulse response for a RoomModel the statistical way: image
+// sources up to the transition time give the early reflections exactly,
+// each through a ReflectionFilterBank lane for the walls it met, after which
+// a noise tail takes over whose level follows from the room's volume and
+// whose decay per octave band follows its Eyring reverberation time. Every
+// band of the tail is rendered broadband and cut out of the spectrum with
+// complementary weights, so the bands sum back to a flat response. A
+// RoomRayTracer's histograms can stand in for the statistical tail, for rooms
+// whose absorption is too uneven for a single exponential decay.
+//
+// Each output channel is a cardioid microphone near the listener, pointing
+// along RoomModel::getMicrophoneAxes() for the output layout. The LFE is
+// left silent.
+namespace RoomIrSynthesis
+{
+
+// Where the image sources stop and the noise tail takes over, growing with
+// the room's volume
+double getTransitionTime (const RoomModel& room);
+
+// Bands are rendered in parallel on pool. Returns an empty buffer as soon as
+// shouldAbort() returns true. With a ray tracer that has traced the room for
+// the same layout, the tail follows its energy histograms instead of the
+// statistical decay, and the response lasts as long as it traced for
+juce::AudioBuffer<float> synthesise (const RoomModel& room,
+                                     double sampleRate,
+                                     const juce::AudioChannelSet& layout,
+                                     juce::ThreadPool& pool,
+                                     const std::function<bool()>& shouldAbort,
+                                     const RoomRayTracer* rayTracer = nullptr);
+
+} // namespace RoomIrSynthesis
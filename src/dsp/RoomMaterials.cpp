@@ -0,0 +1,40 @@
+#include "RoomMaterials.h"
+
+namespace
+{
+
+constexpr RoomMaterials::Material materials[RoomMaterials::numMaterials] {
+    { "Plaster", { 0.01f, 0.02f, 0.02f, 0.03f, 0.04f, 0.05f }, 0.05f },
+    { "Gypsum board", { 0.29f, 0.10f, 0.05f, 0.04f, 0.07f, 0.09f }, 0.05f },
+    { "Concrete", { 0.01f, 0.01f, 0.02f, 0.02f, 0.02f, 0.02f }, 0.05f },
+    { "Brick", { 0.03f, 0.03f, 0.03f, 0.04f, 0.05f, 0.07f }, 0.15f },
+    { "Ceramic tiles", { 0.01f, 0.01f, 0.01f, 0.01f, 0.02f, 0.02f }, 0.05f },
+    { "Glass", { 0.18f, 0.06f, 0.04f, 0.03f, 0.02f, 0.02f }, 0.05f },
+    { "Wood panelling", { 0.28f, 0.22f, 0.17f, 0.09f, 0.10f, 0.11f }, 0.10f },
+    { "Wood floor", { 0.15f, 0.11f, 0.10f, 0.07f, 0.06f, 0.07f }, 0.10f },
+    { "Carpet", { 0.02f, 0.06f, 0.14f, 0.37f, 0.60f, 0.65f }, 0.10f },
+    { "Heavy curtains", { 0.14f, 0.35f, 0.55f, 0.72f, 0.70f, 0.65f }, 0.30f },
+    { "Acoustic tiles", { 0.70f, 0.66f, 0.72f, 0.92f, 0.88f, 0.75f }, 0.20f },
+};
+
+} // namespace
+
+namespace RoomMaterials
+{
+
+const Material& get (int id) noexcept
+{
+    return materials[id >= 0 && id < numMaterials ? id : 0];
+}
+
+juce::StringArray getNames()
+{
+    juce::StringArray names;
+
+    for (const auto& material : materials)
+        names.add (material.name);
+
+    return names;
+}
+
+} // namespace RoomMaterials
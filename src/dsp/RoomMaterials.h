@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+// Octave-band absorption and scattering of common wall finishes, after the
+// usual published measurement tables. The bands here are the ones every room
+// computation works in.
+namespace RoomMaterials
+{
+
+inline constexpr int numBands { 6 };
+inline constexpr std::array<float, numBands> bandCentres { 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f };
+
+using BandValues = std::array<float, numBands>;
+
+// Indices into the table, in the order the menus list them
+enum Id
+{
+    plaster,
+    gypsumBoard,
+    concrete,
+    brick,
+    ceramicTiles,
+    glass,
+    woodPanelling,
+    woodFloor,
+    carpet,
+    heavyCurtains,
+    acousticTiles,
+    numMaterials
+};
+
+struct Material
+{
+    const char* name;
+    BandValues absorption; // energy absorption coefficient per band, 0 to 1
+    float scattering;      // share of the reflected energy scattered diffusely
+};
+
+// Out of range ids give the first material
+const Material& get (int id) noexcept;
+
+juce::StringArray getNames();
+
+} // namespace RoomMaterials
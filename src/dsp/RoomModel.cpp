@@ -0,0 +1,176 @@
+#include "RoomModel.h"
+#include <juce_cryptography/juce_cryptography.h>
+#include <algorithm>
+#include <iterator>
+
+RoomModel::Vector RoomModel::getSourcePosition() const noexcept
+{
+    return { 0.41f * width, 0.27f * length, juce::jmin (1.5f, 0.5f * height) };
+}
+
+RoomModel::Vector RoomModel::getListenerPosition() const noexcept
+{
+    return { 0.57f * width, 0.71f * length, juce::jmin (1.2f, 0.4f * height) };
+}
+
+namespace
+{
+
+// Loudspeaker positions in degrees, azimuth to the left of straight ahead and
+// elevation above the horizontal plane: ITU-R BS.775 and BS.2051 for the
+// surrounds, Dolby's for the heights
+struct SpeakerPosition
+{
+    juce::AudioChannelSet::ChannelType type;
+    float azimuth;
+    float elevation;
+};
+
+constexpr SpeakerPosition speakerPositions[] {
+    { juce::AudioChannelSet::left,                30.0f,  0.0f },
+    { juce::AudioChannelSet::right,              -30.0f,  0.0f },
+    { juce::AudioChannelSet::centre,               0.0f,  0.0f },
+    { juce::AudioChannelSet::leftCentre,          15.0f,  0.0f },
+    { juce::AudioChannelSet::rightCentre,        -15.0f,  0.0f },
+    { juce::AudioChannelSet::wideLeft,            60.0f,  0.0f },
+    { juce::AudioChannelSet::wideRight,          -60.0f,  0.0f },
+    { juce::AudioChannelSet::leftSurroundSide,    90.0f,  0.0f },
+    { juce::AudioChannelSet::rightSurroundSide,  -90.0f,  0.0f },
+    { juce::AudioChannelSet::leftSurround,       110.0f,  0.0f },
+    { juce::AudioChannelSet::rightSurround,     -110.0f,  0.0f },
+    { juce::AudioChannelSet::leftSurroundRear,   150.0f,  0.0f },
+    { juce::AudioChannelSet::rightSurroundRear, -150.0f,  0.0f },
+    { juce::AudioChannelSet::centreSurround,     180.0f,  0.0f },
+    { juce::AudioChannelSet::topFrontLeft,        30.0f, 45.0f },
+    { juce::AudioChannelSet::topFrontRight,      -30.0f, 45.0f },
+    { juce::AudioChannelSet::topFrontCentre,       0.0f, 45.0f },
+    { juce::AudioChannelSet::topSideLeft,         90.0f, 45.0f },
+    { juce::AudioChannelSet::topSideRight,       -90.0f, 45.0f },
+    { juce::AudioChannelSet::topRearLeft,        135.0f, 45.0f },
+    { juce::AudioChannelSet::topRearRight,      -135.0f, 45.0f },
+    { juce::AudioChannelSet::topRearCentre,      180.0f, 45.0f },
+    { juce::AudioChannelSet::topMiddle,            0.0f, 90.0f },
+};
+
+} // namespace
+
+std::vector<std::optional<RoomModel::Vector>> RoomModel::getMicrophoneAxes (const juce::AudioChannelSet& layout) const
+{
+    auto toSource = getSourcePosition() - getListenerPosition();
+    toSource.z = 0.0f;
+
+    const auto distance = toSource.length();
+    const auto forward = distance > 0.0f ? toSource * (1.0f / distance) : Vector { 0.0f, 1.0f, 0.0f };
+    const Vector leftward { -forward.y, forward.x, 0.0f };
+    const Vector up { 0.0f, 0.0f, 1.0f };
+
+    const auto numChannels = layout.size();
+    std::vector<std::optional<Vector>> axes;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto type = layout.getTypeOfChannel (ch);
+
+        if (type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2)
+        {
+            axes.push_back (std::nullopt);
+            continue;
+        }
+
+        const auto* position = std::find_if (std::begin (speakerPositions), std::end (speakerPositions),
+                                             [type] (const auto& p) { return p.type == type; });
+
+        const auto azimuth = position != std::end (speakerPositions)
+                               ? juce::degreesToRadians (position->azimuth)
+                               : juce::MathConstants<float>::pi / 4.0f - juce::MathConstants<float>::twoPi * static_cast<float> (ch) / static_cast<float> (numChannels);
+        const auto elevation = position != std::end (speakerPositions) ? juce::degreesToRadians (position->elevation) : 0.0f;
+
+        axes.push_back ((forward * std::cos (azimuth) + leftward * std::sin (azimuth)) * std::cos (elevation)
+                        + up * std::sin (elevation));
+    }
+
+    return axes;
+}
+
+const RoomModel::BandValues& RoomModel::getAbsorption (int wall) const noexcept
+{
+    return RoomMaterials::get (materials[static_cast<size_t> (wall)]).absorption;
+}
+
+float RoomModel::getScattering (int wall) const noexcept
+{
+    return RoomMaterials::get (materials[static_cast<size_t> (wall)]).scattering;
+}
+
+float RoomModel::getWallArea (Wall wall) const noexcept
+{
+    switch (wall)
+    {
+        case left:
+        case right:   return length * height;
+        case front:
+        case back:    return width * height;
+        case floor:
+        case ceiling: return width * length;
+    }
+
+    return 0.0f;
+}
+
+float RoomModel::getSurfaceArea() const noexcept
+{
+    return 2.0f * (width * length + width * height + length * height);
+}
+
+RoomModel::BandValues RoomModel::getReverbTimes() const noexcept
+{
+    const auto volume = getVolume();
+    const auto surfaceArea = getSurfaceArea();
+    const auto& air = getAirAbsorption();
+    BandValues times {};
+
+    for (size_t band = 0; band < numBands; ++band)
+    {
+        float absorbingArea = 0.0f;
+
+        for (int wall = 0; wall < numWalls; ++wall)
+            absorbingArea += getWallArea (static_cast<Wall> (wall)) * getAbsorption (wall)[band];
+
+        const auto meanAbsorption = juce::jlimit (1.0e-4f, 0.99f, absorbingArea / surfaceArea);
+        const auto sabineConstant = 24.0f * std::log (10.0f) / speedOfSound; // the familiar 0.161 s/m
+        times[band] = sabineConstant * volume / (-surfaceArea * std::log (1.0f - meanAbsorption) + 4.0f * air[band] * volume);
+    }
+
+    return times;
+}
+
+const RoomModel::BandValues& RoomModel::getAirAbsorption() noexcept
+{
+    // ISO 9613-1 attenuation in dB/km, over 10 log10 (e) dB per neper and
+    // 1000 m
+    static const BandValues perMetre { 0.4f / 4343.0f, 1.1f / 4343.0f, 2.3f / 4343.0f,
+                                       4.2f / 4343.0f, 8.2f / 4343.0f, 28.0f / 4343.0f };
+    return perMetre;
+}
+
+juce::String RoomModel::getHash() const
+{
+    juce::MemoryOutputStream out;
+
+    // Centimetres, and the materials' thousandths of absorption and
+    // scattering rather than their indices, so the disk cache can't outlive
+    // an edit of the table
+    for (auto dimension : { width, length, height })
+        out.writeInt (juce::roundToInt (dimension * 100.0f));
+
+    for (int wall = 0; wall < numWalls; ++wall)
+    {
+        for (auto value : getAbsorption (wall))
+            out.writeInt (juce::roundToInt (value * 1000.0f));
+
+        out.writeInt (juce::roundToInt (getScattering (wall) * 1000.0f));
+    }
+
+    // The same form as the file hashes IrCache keys on
+    return juce::SHA256 (out.getData(), out.getDataSize()).toHexString();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "RoomMaterials.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+// A shoebox room: its dimensions in metres, what every wall is made of, and
+// where the source and the listener stand. Everything the
+// room synthesis derives from it is a pure function of these values, so the
+// hash identifies a synthesised impulse response.
+struct RoomModel
+{
+    static constexpr int numBands { RoomMaterials::numBands };
+    static constexpr auto bandCentres { RoomMaterials::bandCentres };
+
+    static constexpr float speedOfSound { 343.0f }; // m/s at 20 degrees C
+
+    enum Wall
+    {
+        left,   // x = 0
+        right,  // x = width
+        front,  // y = 0, behind the source
+        back,   // y = length, behind the listener
+        floor,  // z = 0
+        ceiling // z = height
+    };
+
+    static constexpr int numWalls { 6 };
+
+    using BandValues = RoomMaterials::BandValues;
+
+    // A point or direction in the room, in metres
+    struct Vector
+    {
+        float x { 0.0f }, y { 0.0f }, z { 0.0f };
+
+        Vector operator+ (Vector other) const noexcept { return { x + other.x, y + other.y, z + other.z }; }
+        Vector operator- (Vector other) const noexcept { return { x - other.x, y - other.y, z - other.z }; }
+        Vector operator* (float scale) const noexcept  { return { x * scale, y * scale, z * scale }; }
+        float dot (Vector other) const noexcept        { return x * other.x + y * other.y + z * other.z; }
+        float length() const noexcept                  { return std::sqrt (dot (*this)); }
+
+        bool operator== (const Vector&) const = default;
+    };
+
+    float width { 5.0f };  // x
+    float length { 8.0f }; // y
+    float height { 3.0f }; // z
+
+    // A RoomMaterials::Id per wall
+    std::array<int, numWalls> materials { RoomMaterials::gypsumBoard, RoomMaterials::gypsumBoard,
+                                          RoomMaterials::gypsumBoard, RoomMaterials::gypsumBoard,
+                                          RoomMaterials::woodFloor, RoomMaterials::acousticTiles };
+
+    // Places the source and listener along the room's length, off its centre
+    // line so that image sources don't coincide
+    Vector getSourcePosition() const noexcept;
+    Vector getListenerPosition() const noexcept;
+
+    // Where the listener's microphones point, one per channel of layout:
+    // towards that channel's loudspeaker, with the source straight ahead.
+    // Channels without a standard position are spread evenly in the
+    // horizontal plane, the first 45 degrees left and going clockwise. The
+    // LFE gets no microphone, nullopt, and stays silent
+    std::vector<std::optional<Vector>> getMicrophoneAxes (const juce::AudioChannelSet& layout) const;
+
+    // Energy absorption coefficient per band, 0 to 1
+    const BandValues& getAbsorption (int wall) const noexcept;
+
+    // Share of the reflected energy scattered diffusely rather than mirrored,
+    // 0 to 1
+    float getScattering (int wall) const noexcept;
+
+    float getVolume() const noexcept { return width * length * height; }
+    float getWallArea (Wall wall) const noexcept;
+    float getSurfaceArea() const noexcept;
+
+    // Eyring's reverberation time per band including air absorption. It
+    // reduces to Sabine's for small absorption and stays right for dead rooms
+    BandValues getReverbTimes() const noexcept;
+
+    // Energy absorbed per metre of air per band, at 20 degrees C and 50 % RH
+    static const BandValues& getAirAbsorption() noexcept;
+
+    // Of every field, quantised finely enough that values a user can tell
+    // apart hash apart
+    juce::String getHash() const;
+
+    bool operator== (const RoomModel&) const = default;
+};
@@ -0,0 +1,323 @@
+#include "RoomRayTracer.h"
+#include "ParallelFor.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+using Vector = RoomModel::Vector;
+
+constexpr int raysPerBatch { 32 };
+constexpr float minimumEnergy { 1.0e-7f }; // 70 dB down, where a ray is dropped
+
+// Units per unit of histogram energy. A hit adds at most 2, the receiver's
+// largest diameter, which leaves room for millions of hits per bin
+constexpr double fixedPointScale { 1099511627776.0 }; // 2^40
+
+// Splits [0, numItems) into one range per worker. A worker takes items off
+// the front of its own range and, once that is empty, steals the back half of
+// the largest remaining one. Ranges only ever shrink or get refilled with
+// items that were never in them before, so a compare-and-swap on one can't
+// be fooled by it returning to an earlier value
+class WorkStealingRanges
+{
+public:
+    WorkStealingRanges (int numItems, int numWorkers)
+        : ranges (static_cast<size_t> (numWorkers))
+    {
+        for (int w = 0; w < numWorkers; ++w)
+            ranges[static_cast<size_t> (w)] = pack (numItems * w / numWorkers, numItems * (w + 1) / numWorkers);
+    }
+
+    // The next item for worker, or -1 once every range is empty
+    int next (int worker)
+    {
+        auto& own = ranges[static_cast<size_t> (worker)];
+
+        for (;;)
+        {
+            auto range = own.load();
+            const auto begin = getBegin (range), end = getEnd (range);
+
+            if (begin < end)
+            {
+                if (own.compare_exchange_weak (range, pack (begin + 1, end)))
+                    return begin;
+            }
+            else if (! steal (worker))
+            {
+                return -1;
+            }
+        }
+    }
+
+private:
+    bool steal (int thief)
+    {
+        for (;;)
+        {
+            int victim = -1, largest = 0;
+            juce::uint64 victimRange = 0;
+
+            for (int w = 0; w < static_cast<int> (ranges.size()); ++w)
+            {
+                const auto range = ranges[static_cast<size_t> (w)].load();
+
+                if (const auto size = getEnd (range) - getBegin (range); w != thief && size > largest)
+                {
+                    victim = w;
+                    largest = size;
+                    victimRange = range;
+                }
+            }
+
+            if (victim < 0)
+                return false;
+
+            // The victim keeps the front half, which it is working through
+            const auto begin = getBegin (victimRange), end = getEnd (victimRange);
+            const auto middle = begin + (end - begin) / 2;
+
+            if (ranges[static_cast<size_t> (victim)].compare_exchange_strong (victimRange, pack (begin, middle)))
+            {
+                ranges[static_cast<size_t> (thief)] = pack (middle, end);
+                return true;
+            }
+        }
+    }
+
+    static juce::uint64 pack (int begin, int end)
+    {
+        return static_cast<juce::uint64> (static_cast<juce::uint32> (end)) << 32 | static_cast<juce::uint32> (begin);
+    }
+
+    static int getBegin (juce::uint64 range) { return static_cast<int> (range & 0xffffffff); }
+    static int getEnd (juce::uint64 range) { return static_cast<int> (range >> 32); }
+
+    std::vector<std::atomic<juce::uint64>> ranges;
+};
+
+// Decorrelates neighbouring ray indices before they seed a generator
+juce::int64 getSeed (int index)
+{
+    auto x = static_cast<juce::uint64> (index) + 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<juce::int64> (x ^ (x >> 31));
+}
+
+Vector getRandomDirection (juce::Random& random)
+{
+    const auto z = 2.0f * random.nextFloat() - 1.0f;
+    const auto azimuth = juce::MathConstants<float>::twoPi * random.nextFloat();
+    const auto radius = std::sqrt (juce::jmax (0.0f, 1.0f - z * z));
+    return { radius * std::cos (azimuth), radius * std::sin (azimuth), z };
+}
+
+} // namespace
+
+struct RoomRayTracer::Histogram
+{
+    explicit Histogram (size_t size) : energy (size) {}
+
+    std::vector<juce::int64> energy; // [channel][band][bin], one worker's rays
+};
+
+RoomRayTracer::RoomRayTracer (const RoomModel& roomToTrace, const juce::AudioChannelSet& layoutToRecord, double maxSeconds)
+    : room (roomToTrace)
+    , numChannels (layoutToRecord.size())
+    , numBins (juce::jmax (1, static_cast<int> (std::ceil (maxSeconds / binSeconds))))
+    // Bigger rooms take a bigger receiver, for as many hits per ray, but it
+    // has to stay clear of the source
+    , receiverRadius (juce::jmin (juce::jlimit (0.2f, 1.0f, 0.1f * std::cbrt (roomToTrace.getVolume())),
+                                  0.5f * (roomToTrace.getSourcePosition() - roomToTrace.getListenerPosition()).length()))
+    , microphoneAxes (roomToTrace.getMicrophoneAxes (layoutToRecord))
+    , energy (static_cast<size_t> (numChannels * RoomModel::numBands * numBins))
+{
+}
+
+bool RoomRayTracer::trace (int numRaysToAdd, juce::ThreadPool& pool, const std::function<bool()>& shouldAbort)
+{
+    const auto numBatches = (numRaysToAdd + raysPerBatch - 1) / raysPerBatch;
+    const auto numWorkers = juce::jlimit (1, juce::jmax (1, numBatches), pool.getNumThreads());
+    const auto firstRay = numRays;
+
+    WorkStealingRanges batches (numBatches, numWorkers);
+    std::vector<Histogram> histograms (static_cast<size_t> (numWorkers), Histogram (energy.size()));
+    std::atomic<bool> aborted { false };
+
+    parallelFor (pool, numWorkers, [&] (int worker)
+    {
+        auto& histogram = histograms[static_cast<size_t> (worker)];
+
+        for (int batch; ! aborted && (batch = batches.next (worker)) >= 0;)
+        {
+            if (shouldAbort())
+            {
+                aborted = true;
+                break;
+            }
+
+            const auto end = juce::jmin (numRaysToAdd, (batch + 1) * raysPerBatch);
+
+            for (int ray = batch * raysPerBatch; ray < end; ++ray)
+                traceRay (firstRay + ray, histogram);
+        }
+    });
+
+    if (aborted)
+        return false;
+
+    for (const auto& histogram : histograms)
+        for (size_t i = 0; i < energy.size(); ++i)
+            energy[i] += histogram.energy[i];
+
+    numRays += numRaysToAdd;
+    return true;
+}
+
+float RoomRayTracer::getEnergy (int channel, int band, int bin) const noexcept
+{
+    if (numRays == 0)
+        return 0.0f;
+
+    // A ray's energy density inside the receiver is its path length through
+    // it over the sphere's volume. Over many rays that averages to
+    // 1 / (4 pi d^2) at distance d from a unit source, so 4 pi times it is
+    // the 1 / d^2 an image source's squared amplitude falls off with
+    const auto scale = 3.0 / (static_cast<double> (numRays) * std::pow (static_cast<double> (receiverRadius), 3.0));
+    return static_cast<float> (scale / fixedPointScale * static_cast<double> (energy[static_cast<size_t> ((channel * RoomModel::numBands + band) * numBins + bin)]));
+}
+
+int RoomRayTracer::getDecayedLength() const noexcept
+{
+    int length = 0;
+
+    for (int row = 0; row < numChannels * RoomModel::numBands; ++row)
+        for (int bin = numBins; --bin >= length;)
+            if (energy[static_cast<size_t> (row * numBins + bin)] > 0)
+                length = bin + 1;
+
+    return juce::jmax (1, length);
+}
+
+void RoomRayTracer::traceRay (int index, Histogram& histogram) const
+{
+    juce::Random random (getSeed (index));
+
+    const float sizes[] { room.width, room.length, room.height };
+    const auto listener = room.getListenerPosition();
+    const auto& air = RoomModel::getAirAbsorption();
+    const auto maxDistance = static_cast<float> (numBins * binSeconds) * RoomModel::speedOfSound;
+    const auto radiusSquared = receiverRadius * receiverRadius;
+
+    auto position = room.getSourcePosition();
+    auto direction = getRandomDirection (random);
+    RoomModel::BandValues bandEnergy;
+    bandEnergy.fill (1.0f);
+    float travelled = 0.0f;
+
+    while (travelled < maxDistance)
+    {
+        // The wall the ray meets next
+        const float p[] { position.x, position.y, position.z };
+        const float d[] { direction.x, direction.y, direction.z };
+        auto distance = std::numeric_limits<float>::max();
+        int hitAxis = 0;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (juce::exactlyEqual (d[axis], 0.0f))
+                continue;
+
+            const auto toWall = ((d[axis] > 0.0f ? sizes[axis] : 0.0f) - p[axis]) / d[axis];
+
+            if (toWall < distance)
+            {
+                distance = juce::jmax (0.0f, toWall);
+                hitAxis = axis;
+            }
+        }
+
+        // Through the receiver on the way there?
+        const auto fromListener = position - listener;
+        const auto b = fromListener.dot (direction);
+        const auto discriminant = b * b - (fromListener.dot (fromListener) - radiusSquared);
+
+        if (discriminant > 0.0f)
+        {
+            const auto root = std::sqrt (discriminant);
+            const auto entry = juce::jmax (0.0f, -b - root);
+            const auto exit = juce::jmin (distance, -b + root);
+
+            if (exit > entry)
+            {
+                const auto arrival = travelled + 0.5f * (entry + exit);
+                const auto bin = static_cast<int> (arrival / RoomModel::speedOfSound / static_cast<float> (binSeconds));
+
+                if (bin < numBins)
+                {
+                    for (int ch = 0; ch < numChannels; ++ch)
+                    {
+                        const auto& axis = microphoneAxes[static_cast<size_t> (ch)];
+
+                        if (! axis.has_value())
+                            continue;
+
+                        // Sound arrives from where the ray came
+                        const auto cardioid = 0.5f * (1.0f - axis->dot (direction));
+                        const auto weight = (exit - entry) * cardioid * cardioid;
+
+                        for (size_t band = 0; band < RoomModel::numBands; ++band)
+                        {
+                            const auto hit = weight * bandEnergy[band] * std::exp (-air[band] * arrival);
+                            histogram.energy[(static_cast<size_t> (ch) * RoomModel::numBands + band) * static_cast<size_t> (numBins) + static_cast<size_t> (bin)]
+                                += static_cast<juce::int64> (static_cast<double> (hit) * fixedPointScale + 0.5);
+                        }
+                    }
+                }
+            }
+        }
+
+        position = position + direction * distance;
+        travelled += distance;
+
+        const auto wall = 2 * hitAxis + (d[hitAxis] > 0.0f ? 1 : 0);
+        const auto& absorption = room.getAbsorption (wall);
+        float loudest = 0.0f;
+
+        for (size_t band = 0; band < RoomModel::numBands; ++band)
+        {
+            bandEnergy[band] *= 1.0f - absorption[band];
+            loudest = juce::jmax (loudest, bandEnergy[band] * std::exp (-air[band] * travelled));
+        }
+
+        if (loudest < minimumEnergy)
+            break;
+
+        // Pinned to the wall against rounding, then off it again
+        float onWall[] { position.x, position.y, position.z };
+        onWall[hitAxis] = d[hitAxis] > 0.0f ? sizes[hitAxis] : 0.0f;
+        position = { onWall[0], onWall[1], onWall[2] };
+
+        if (random.nextFloat() < room.getScattering (wall))
+        {
+            // Lambertian: cosine-weighted about the inward normal
+            const auto radius = std::sqrt (random.nextFloat());
+            const auto azimuth = juce::MathConstants<float>::twoPi * random.nextFloat();
+            float scattered[3];
+            scattered[hitAxis] = (d[hitAxis] > 0.0f ? -1.0f : 1.0f) * std::sqrt (juce::jmax (0.0f, 1.0f - radius * radius));
+            scattered[(hitAxis + 1) % 3] = radius * std::cos (azimuth);
+            scattered[(hitAxis + 2) % 3] = radius * std::sin (azimuth);
+            direction = { scattered[0], scattered[1], scattered[2] };
+        }
+        else
+        {
+            float mirrored[] { d[0], d[1], d[2] };
+            mirrored[hitAxis] = -mirrored[hitAxis];
+            direction = { mirrored[0], mirrored[1], mirrored[2] };
+        }
+    }
+}
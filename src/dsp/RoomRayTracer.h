@@ -0,0 +1,64 @@
+#pragma once
+
+#include "RoomModel.h"
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <optional>
+#include <vector>
+
+// Stochastic ray tracer for a RoomModel. Rays leave the source in random
+// directions, lose energy per band at every wall and in the air, and reflect
+// either specularly or, as often as the wall's material scatters, in a random
+// Lambertian direction. Whenever one crosses a sphere around the listener its
+// energy lands in a histogram per output channel, band and time bin, weighted
+// by the channel's cardioid microphone. Channels without one, the LFE, stay
+// empty.
+//
+// Unlike image sources its cost only grows linearly with the time traced, and
+// it can be refined: every trace() adds rays to the histograms, so a coarse
+// first pass is usable within milliseconds. Ray n always takes the same path
+// and energy is summed in fixed point, in which the order of the sum doesn't
+// matter, so the same room traced with the same number of rays gives the
+// same result however the rays were split between threads and passes.
+class RoomRayTracer final
+{
+public:
+    static constexpr double binSeconds { 0.004 };
+
+    // Records a channel per channel of layoutToRecord, for maxSeconds of
+    // arrival time
+    RoomRayTracer (const RoomModel& roomToTrace, const juce::AudioChannelSet& layoutToRecord, double maxSeconds);
+
+    // Traces numRays more on pool, each worker stealing batches of rays from
+    // the others once it runs out of its own. Blocks until they are done;
+    // returns false, leaving the histograms as they were, if shouldAbort()
+    // returned true meanwhile
+    bool trace (int numRays, juce::ThreadPool& pool, const std::function<bool()>& shouldAbort);
+
+    int getNumRays() const noexcept { return numRays; }
+    int getNumBins() const noexcept { return numBins; }
+    int getNumChannels() const noexcept { return numChannels; }
+
+    // Bins up to the last any ray reached before it decayed away
+    int getDecayedLength() const noexcept;
+
+    // Energy reaching channel in band during bin, on the same scale as an
+    // image source's squared amplitude, so 1 at 1 m. Zero before any rays
+    float getEnergy (int channel, int band, int bin) const noexcept;
+
+private:
+    struct Histogram;
+
+    void traceRay (int index, Histogram& histogram) const;
+
+    const RoomModel room;
+    const int numChannels;
+    const int numBins;
+    const float receiverRadius;
+    const std::vector<std::optional<RoomModel::Vector>> microphoneAxes;
+
+    std::vector<juce::int64> energy; // [channel][band][bin], summed over every ray
+    int numRays { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RoomRayTracer)
+};
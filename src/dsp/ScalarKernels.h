@@ -0,0 +1,282 @@
+#pragma once
+
+#include "DelaySample.h"
+#include "SimdKernels.h"
+
+// Reference implementations of the SimdKernels, generic over the delay line
+// storage format. These keep the exact arithmetic of juce::Reverb and are
+// what the 16-bit formats run with.
+namespace ScalarKernels
+{
+
+template <typename Format, int Channels, int Lines>
+void combBank (SimdKernels::CombBank& bank,
+               const float* input,
+               const float* damping,
+               const float* feedback,
+               float* const* outputs,
+               int numSamples) noexcept
+{
+    static_assert (Channels * Lines <= SimdKernels::CombBank::maxLanes);
+
+    auto* base = static_cast<typename Format::Type*> (bank.base);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto damp = damping[i];
+        const auto feedbackLevel = feedback[i];
+
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            float sum = 0;
+
+            for (int lane = ch * Lines; lane < (ch + 1) * Lines; ++lane)
+            {
+                auto* sample = base + bank.offsets[lane] + bank.indices[lane];
+                const auto output = Format::load (*sample);
+
+                auto last = (output * (1.0f - damp)) + (bank.last[lane] * damp);
+                JUCE_UNDENORMALISE (last);
+                bank.last[lane] = last;
+
+                auto temp = input[i] + (last * feedbackLevel);
+                JUCE_UNDENORMALISE (temp);
+                *sample = Format::store (temp);
+
+                if (++bank.indices[lane] >= bank.sizes[lane])
+                    bank.indices[lane] = 0;
+
+                sum += output;
+            }
+
+            outputs[ch][i] = sum;
+        }
+    }
+}
+
+template <typename Format, int Lines>
+void monoToStereoCombBank (SimdKernels::CombBank& bank,
+                           const float* input,
+                           const float* damping,
+                           const float* feedback,
+                           float* const* outputs,
+                           int numSamples) noexcept
+{
+    static_assert (Lines <= SimdKernels::CombBank::maxLanes);
+
+    auto* base = static_cast<typename Format::Type*> (bank.base);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto damp = damping[i];
+        const auto feedbackLevel = feedback[i];
+        float sum = 0, tapSum = 0;
+
+        for (int lane = 0; lane < Lines; ++lane)
+        {
+            auto* line = base + bank.offsets[lane];
+            auto tap = bank.indices[lane] + bank.taps[lane];
+
+            if (tap >= bank.sizes[lane])
+                tap -= bank.sizes[lane];
+
+            tapSum += Format::load (line[tap]);
+
+            const auto output = Format::load (line[bank.indices[lane]]);
+
+            auto last = (output * (1.0f - damp)) + (bank.last[lane] * damp);
+            JUCE_UNDENORMALISE (last);
+            bank.last[lane] = last;
+
+            auto temp = input[i] + (last * feedbackLevel);
+            JUCE_UNDENORMALISE (temp);
+            line[bank.indices[lane]] = Format::store (temp);
+
+            if (++bank.indices[lane] >= bank.sizes[lane])
+                bank.indices[lane] = 0;
+
+            sum += output;
+        }
+
+        outputs[0][i] = sum;
+        outputs[1][i] = tapSum;
+    }
+}
+
+// One line's decay filter, transposed direct form II
+inline float decayFilter (SimdKernels::CombBank& bank, int lane, float output) noexcept
+{
+    const auto& d = bank.decay;
+    const auto filtered = d.b0[lane] * output + bank.decayState1[lane];
+
+    auto state1 = d.b1[lane] * output - d.a1[lane] * filtered + bank.decayState2[lane];
+    auto state2 = d.b2[lane] * output - d.a2[lane] * filtered;
+    JUCE_UNDENORMALISE (state1);
+    JUCE_UNDENORMALISE (state2);
+    bank.decayState1[lane] = state1;
+    bank.decayState2[lane] = state2;
+
+    return filtered;
+}
+
+template <typename Format, int Channels, int Lines>
+void decayCombBank (SimdKernels::CombBank& bank, const float* input, float* const* outputs, int numSamples) noexcept
+{
+    static_assert (Channels * Lines <= SimdKernels::CombBank::maxLanes);
+
+    auto* base = static_cast<typename Format::Type*> (bank.base);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            float sum = 0;
+
+            for (int lane = ch * Lines; lane < (ch + 1) * Lines; ++lane)
+            {
+                auto* sample = base + bank.offsets[lane] + bank.indices[lane];
+                const auto output = Format::load (*sample);
+
+                auto temp = input[i] + decayFilter (bank, lane, output);
+                JUCE_UNDENORMALISE (temp);
+                *sample = Format::store (temp);
+
+                if (++bank.indices[lane] >= bank.sizes[lane])
+                    bank.indices[lane] = 0;
+
+                sum += output;
+            }
+
+            outputs[ch][i] = sum;
+        }
+    }
+}
+
+template <typename Format, int Lines>
+void decayMonoToStereoCombBank (SimdKernels::CombBank& bank, const float* input, float* const* outputs, int numSamples) noexcept
+{
+    static_assert (Lines <= SimdKernels::CombBank::maxLanes);
+
+    auto* base = static_cast<typename Format::Type*> (bank.base);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float sum = 0, tapSum = 0;
+
+        for (int lane = 0; lane < Lines; ++lane)
+        {
+            auto* line = base + bank.offsets[lane];
+            auto tap = bank.indices[lane] + bank.taps[lane];
+
+            if (tap >= bank.sizes[lane])
+                tap -= bank.sizes[lane];
+
+            tapSum += Format::load (line[tap]);
+
+            const auto output = Format::load (line[bank.indices[lane]]);
+
+            auto temp = input[i] + decayFilter (bank, lane, output);
+            JUCE_UNDENORMALISE (temp);
+            line[bank.indices[lane]] = Format::store (temp);
+
+            if (++bank.indices[lane] >= bank.sizes[lane])
+                bank.indices[lane] = 0;
+
+            sum += output;
+        }
+
+        outputs[0][i] = sum;
+        outputs[1][i] = tapSum;
+    }
+}
+
+template <typename Format>
+void allPass (SimdKernels::AllPass& allPass, float* samples, int numSamples) noexcept
+{
+    auto* buffer = static_cast<typename Format::Type*> (allPass.buffer);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto input = samples[i];
+        const auto bufferedValue = Format::load (buffer[allPass.index]);
+
+        auto temp = input + (bufferedValue * 0.5f);
+        JUCE_UNDENORMALISE (temp);
+        buffer[allPass.index] = Format::store (temp);
+
+        if (++allPass.index >= allPass.size)
+            allPass.index = 0;
+
+        samples[i] = bufferedValue - input;
+    }
+}
+
+// Runs every sample through the whole chain before the next, the same
+// arithmetic as calling allPass() on the block once per filter. For blocks
+// of a few samples this saves a call and loop setup per filter
+template <typename Format, size_t NumAllPasses>
+void allPassChain (SimdKernels::AllPass (&chain)[NumAllPasses], float* samples, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto sample = samples[i];
+
+        for (auto& allPass : chain)
+        {
+            auto* buffer = static_cast<typename Format::Type*> (allPass.buffer);
+            const auto bufferedValue = Format::load (buffer[allPass.index]);
+
+            auto temp = sample + (bufferedValue * 0.5f);
+            JUCE_UNDENORMALISE (temp);
+            buffer[allPass.index] = Format::store (temp);
+
+            if (++allPass.index >= allPass.size)
+                allPass.index = 0;
+
+            sample = bufferedValue - sample;
+        }
+
+        samples[i] = sample;
+    }
+}
+
+inline void magnitudes (const float* interleaved, float* dest, int numBins) noexcept
+{
+    for (int i = 0; i < numBins; ++i)
+    {
+        const auto re = interleaved[2 * i];
+        const auto im = interleaved[2 * i + 1];
+        dest[i] = std::sqrt (re * re + im * im);
+    }
+}
+
+inline void peakHold (const float* magnitudes,
+                      const int32_t* bins,
+                      const float* previous,
+                      float decay,
+                      float* scope,
+                      int numPoints) noexcept
+{
+    for (int i = 0; i < numPoints; ++i)
+        scope[i] = juce::jmax (magnitudes[bins[i]], previous[i] * decay);
+}
+
+inline void sparseFir (const float* input,
+                       const int32_t* offsets,
+                       const float* gains,
+                       int numTaps,
+                       float* output,
+                       int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float sum = 0.0f;
+
+        for (int k = 0; k < numTaps; ++k)
+            sum += gains[k] * input[i + offsets[k]];
+
+        output[i] = sum;
+    }
+}
+
+} // namespace ScalarKernels
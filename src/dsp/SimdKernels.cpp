@@ -0,0 +1,319 @@
+#include "SimdKernels.h"
+#include "ScalarKernels.h"
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace SimdKernels
+{
+
+namespace
+{
+
+template <size_t... Layouts>
+constexpr Table makeScalarTable (std::index_sequence<Layouts...>) noexcept
+{
+    Table table;
+    table.name = "scalar";
+    ((table.combBanks[combBankChannelCounts[Layouts]]
+      = ScalarKernels::combBank<Float32Sample, combBankChannelCounts[Layouts], CombBank::maxLinesPerChannel>),
+     ...);
+    ((table.decayCombBanks[combBankChannelCounts[Layouts]]
+      = ScalarKernels::decayCombBank<Float32Sample, combBankChannelCounts[Layouts], CombBank::maxLinesPerChannel>),
+     ...);
+    table.monoToStereoCombBank = ScalarKernels::monoToStereoCombBank<Float32Sample, CombBank::maxLinesPerChannel>;
+    table.decayMonoToStereoCombBank = ScalarKernels::decayMonoToStereoCombBank<Float32Sample, CombBank::maxLinesPerChannel>;
+    table.allPass = ScalarKernels::allPass<Float32Sample>;
+    table.magnitudes = ScalarKernels::magnitudes;
+    table.peakHold = ScalarKernels::peakHold;
+    table.sparseFir = ScalarKernels::sparseFir;
+    return table;
+}
+
+} // namespace
+
+const Table& getScalar()
+{
+    static constexpr Table table { makeScalarTable (std::make_index_sequence<std::size (combBankChannelCounts)> {}) };
+    return table;
+}
+
+namespace
+{
+
+bool isClose (float actual, float expected) noexcept
+{
+    return std::abs (actual - expected) <= 1.0e-5f * juce::jmax (1.0f, std::abs (expected));
+}
+
+bool isClose (const std::vector<float>& actual, const std::vector<float>& expected) noexcept
+{
+    return std::equal (actual.begin(), actual.end(), expected.begin(), expected.end(),
+                       [] (float a, float b) { return isClose (a, b); });
+}
+
+std::vector<float> makeNoise (juce::Random& random, int numSamples)
+{
+    std::vector<float> noise (static_cast<size_t> (numSamples));
+
+    for (auto& sample : noise)
+        sample = random.nextFloat() * 2.0f - 1.0f;
+
+    return noise;
+}
+
+// Runs both comb banks over lines of random length, long enough for every
+// line to wrap a few times, in uneven blocks. Decay comb banks get a random
+// stable filter per line whose gain stays below one
+template <typename Kernel>
+bool combBankMatches (Kernel variant,
+                      Kernel reference,
+                      juce::Random& random,
+                      int numLanes,
+                      int numOutputs)
+{
+    constexpr bool withDecay { std::is_same_v<Kernel, DecayCombBankFunction> };
+
+    constexpr int numSamples { 1500 };
+
+    CombBank banks[2];
+    int totalLength {};
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto size = 37 + random.nextInt (300);
+        const auto index = random.nextInt (size);
+        const auto tap = 1 + random.nextInt (size - 1);
+
+        // Poles within 0.5 of the origin, and numerator coefficients summing
+        // to under 0.9 (1 - r)^2, bound the gain by 0.9
+        const auto radius = 0.5f * random.nextFloat();
+        const auto angle = juce::MathConstants<float>::pi * random.nextFloat();
+        const auto numeratorScale = 0.3f * juce::square (1.0f - radius);
+
+        const auto b0 = numeratorScale * random.nextFloat();
+        const auto b1 = numeratorScale * (2.0f * random.nextFloat() - 1.0f);
+        const auto b2 = numeratorScale * (2.0f * random.nextFloat() - 1.0f);
+
+        for (auto& bank : banks)
+        {
+            bank.offsets[lane] = totalLength;
+            bank.sizes[lane] = size;
+            bank.indices[lane] = index;
+            bank.taps[lane] = tap;
+            bank.decay.b0[lane] = b0;
+            bank.decay.b1[lane] = b1;
+            bank.decay.b2[lane] = b2;
+            bank.decay.a1[lane] = -2.0f * radius * std::cos (angle);
+            bank.decay.a2[lane] = radius * radius;
+        }
+
+        totalLength += size;
+    }
+
+    std::vector<float> lines[2] { makeNoise (random, totalLength), {} };
+    lines[1] = lines[0];
+    banks[0].base = lines[0].data();
+    banks[1].base = lines[1].data();
+
+    const auto input = makeNoise (random, numSamples);
+    std::vector<float> damping (numSamples), feedback (numSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        damping[static_cast<size_t> (i)] = 0.4f * random.nextFloat();
+        feedback[static_cast<size_t> (i)] = 0.7f + 0.28f * random.nextFloat();
+    }
+
+    std::vector<float> outputs[2][ProcessingLimits::maxChannels];
+    float* outputPointers[2][ProcessingLimits::maxChannels];
+
+    for (int t = 0; t < 2; ++t)
+    {
+        for (int ch = 0; ch < ProcessingLimits::maxChannels; ++ch)
+        {
+            outputs[t][ch].resize (numSamples);
+            outputPointers[t][ch] = outputs[t][ch].data();
+        }
+    }
+
+    const Kernel kernels[2] { variant, reference };
+
+    for (int start = 0; start < numSamples;)
+    {
+        const auto n = juce::jmin (numSamples - start, 1 + random.nextInt (200));
+
+        for (int t = 0; t < 2; ++t)
+        {
+            float* blockOutputs[ProcessingLimits::maxChannels];
+
+            for (int ch = 0; ch < numOutputs; ++ch)
+                blockOutputs[ch] = outputPointers[t][ch] + start;
+
+            if constexpr (withDecay)
+                kernels[t] (banks[t], input.data() + start, blockOutputs, n);
+            else
+                kernels[t] (banks[t], input.data() + start, damping.data() + start, feedback.data() + start, blockOutputs, n);
+        }
+
+        start += n;
+    }
+
+    for (int ch = 0; ch < numOutputs; ++ch)
+        if (! isClose (outputs[0][ch], outputs[1][ch]))
+            return false;
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        if (banks[0].indices[lane] != banks[1].indices[lane] || ! isClose (banks[0].last[lane], banks[1].last[lane])
+            || ! isClose (banks[0].decayState1[lane], banks[1].decayState1[lane])
+            || ! isClose (banks[0].decayState2[lane], banks[1].decayState2[lane]))
+            return false;
+
+    return isClose (lines[0], lines[1]);
+}
+
+bool allPassMatches (const Table& variant, const Table& reference, juce::Random& random)
+{
+    constexpr int size { 53 };
+    constexpr int numSamples { 700 };
+
+    std::vector<float> lines[2] { makeNoise (random, size), {} };
+    lines[1] = lines[0];
+
+    const auto index = random.nextInt (size);
+    AllPass allPasses[2] { { lines[0].data(), size, index }, { lines[1].data(), size, index } };
+    std::vector<float> samples[2] { makeNoise (random, numSamples), {} };
+    samples[1] = samples[0];
+
+    for (int start = 0; start < numSamples;)
+    {
+        const auto n = juce::jmin (numSamples - start, 1 + random.nextInt (120));
+        variant.allPass (allPasses[0], samples[0].data() + start, n);
+        reference.allPass (allPasses[1], samples[1].data() + start, n);
+        start += n;
+    }
+
+    return allPasses[0].index == allPasses[1].index
+        && isClose (lines[0], lines[1])
+        && isClose (samples[0], samples[1]);
+}
+
+bool analyzerMatches (const Table& variant, const Table& reference, juce::Random& random)
+{
+    constexpr int numBins { 1025 }; // not a multiple of any vector width
+    constexpr int numPoints { 203 };
+
+    const auto interleaved = makeNoise (random, 2 * numBins);
+    std::vector<float> magnitudes[2] { std::vector<float> (numBins), std::vector<float> (numBins) };
+    variant.magnitudes (interleaved.data(), magnitudes[0].data(), numBins);
+    reference.magnitudes (interleaved.data(), magnitudes[1].data(), numBins);
+
+    if (! isClose (magnitudes[0], magnitudes[1]))
+        return false;
+
+    std::vector<int32_t> bins (numPoints);
+
+    for (auto& bin : bins)
+        bin = random.nextInt (numBins);
+
+    const auto previous = makeNoise (random, numPoints);
+    std::vector<float> scopes[2] { std::vector<float> (numPoints), std::vector<float> (numPoints) };
+    variant.peakHold (magnitudes[1].data(), bins.data(), previous.data(), 0.7f, scopes[0].data(), numPoints);
+    reference.peakHold (magnitudes[1].data(), bins.data(), previous.data(), 0.7f, scopes[1].data(), numPoints);
+
+    return scopes[0] == scopes[1];
+}
+
+// Offsets spread over a history longer than the block, which is odd so
+// every vector width leaves a remainder
+bool sparseFirMatches (const Table& variant, const Table& reference, juce::Random& random)
+{
+    constexpr int numHistory { 2000 };
+    constexpr int numSamples { 301 };
+
+    const auto input = makeNoise (random, numHistory + numSamples);
+
+    for (auto numTaps : { 1, 37, 100 })
+    {
+        std::vector<int32_t> offsets (static_cast<size_t> (numTaps));
+        const auto gains = makeNoise (random, numTaps);
+
+        for (auto& offset : offsets)
+            offset = -random.nextInt (numHistory + 1);
+
+        std::vector<float> outputs[2] { std::vector<float> (numSamples), std::vector<float> (numSamples) };
+        variant.sparseFir (input.data() + numHistory, offsets.data(), gains.data(), numTaps, outputs[0].data(), numSamples);
+        reference.sparseFir (input.data() + numHistory, offsets.data(), gains.data(), numTaps, outputs[1].data(), numSamples);
+
+        if (! isClose (outputs[0], outputs[1]))
+            return false;
+    }
+
+    return true;
+}
+
+bool matchesScalar (const Table& variant)
+{
+    juce::Random random (0x3d4e);
+    const auto& reference = getScalar();
+
+    for (auto numChannels : combBankChannelCounts)
+    {
+        const auto numLanes = numChannels * CombBank::maxLinesPerChannel;
+
+        if (! combBankMatches (variant.combBanks[numChannels], reference.combBanks[numChannels], random, numLanes, numChannels)
+            || ! combBankMatches (variant.decayCombBanks[numChannels], reference.decayCombBanks[numChannels], random, numLanes, numChannels))
+            return false;
+    }
+
+    return combBankMatches (variant.monoToStereoCombBank, reference.monoToStereoCombBank, random, CombBank::maxLinesPerChannel, 2)
+        && combBankMatches (variant.decayMonoToStereoCombBank, reference.decayMonoToStereoCombBank, random, CombBank::maxLinesPerChannel, 2)
+        && allPassMatches (variant, reference, random)
+        && analyzerMatches (variant, reference, random)
+        && sparseFirMatches (variant, reference, random);
+}
+
+// Every variant this CPU supports is tested, not just the one picked, so a
+// broken narrower one is caught on machines that would never run it
+const Table& selectBest()
+{
+    // Fastest first
+    const Table* candidates[] {
+        juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL() ? getAvx512() : nullptr,
+        juce::SystemStats::hasAVX2() ? getAvx2() : nullptr,
+        juce::SystemStats::hasSSE2() ? getSse2() : nullptr,
+        juce::SystemStats::hasNeon() ? getNeon() : nullptr
+    };
+
+    const Table* best = nullptr;
+
+    for (auto* candidate : candidates)
+    {
+        if (candidate == nullptr)
+            continue;
+
+        if (matchesScalar (*candidate))
+        {
+            if (best == nullptr)
+                best = candidate;
+        }
+        else
+        {
+            // A variant that disagrees with the reference is a bug, but the
+            // plug-in can still run on the next one that passed
+            jassertfalse;
+        }
+    }
+
+    return best != nullptr ? *best : getScalar();
+}
+
+} // namespace
+
+const Table& getBest()
+{
+    static const Table& best = selectBest();
+    return best;
+}
+
+} // namespace SimdKernels
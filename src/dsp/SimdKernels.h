@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ProcessingLimits.h"
+#include <cstdint>
+
+// Hot loops of the reverb and the spectrum analyzer, compiled once per
+// instruction set (see the SimdKernels*.cpp files) and picked at run time.
+// This header is shared with those translation units, so it must stay free
+// of inline code: anything inline compiled with e.g. AVX2 enabled could be
+// the copy the linker keeps for the whole plug-in.
+namespace SimdKernels
+{
+
+// The feedback combs of one Freeverb bank, one lane per comb. With L combs
+// per channel, lanes [ch * L, (ch + 1) * L) sum into channel ch.
+struct CombBank
+{
+    static constexpr int maxLinesPerChannel { 8 };
+    static constexpr int maxLanes { ProcessingLimits::maxChannels * maxLinesPerChannel };
+
+    void* base { nullptr }; // lines are addressed in samples from here
+    alignas (64) int32_t offsets[maxLanes] {};
+    alignas (64) int32_t sizes[maxLanes] {};
+    alignas (64) int32_t indices[maxLanes] {};
+    alignas (64) float last[maxLanes] {};
+
+    // Second read position per line for the mono-in/stereo-out bank, in
+    // samples after the output tap
+    alignas (64) int32_t taps[maxLanes] {};
+
+    // What the decay comb banks feed back instead of the damped output times
+    // the feedback level: each line's output through its own biquad, which
+    // includes the line's loss per trip. Normalised, a0 = 1
+    struct DecayFilters
+    {
+        alignas (64) float b0[maxLanes] {};
+        alignas (64) float b1[maxLanes] {};
+        alignas (64) float b2[maxLanes] {};
+        alignas (64) float a1[maxLanes] {};
+        alignas (64) float a2[maxLanes] {};
+    };
+
+    DecayFilters decay;
+
+    // The biquads' state, transposed direct form II
+    alignas (64) float decayState1[maxLanes] {};
+    alignas (64) float decayState2[maxLanes] {};
+};
+
+struct AllPass
+{
+    void* buffer { nullptr };
+    int size {};
+    int index {};
+};
+
+// outputs[ch][i] = sum of channel ch's combs fed with input[i]
+using CombBankFunction = void (*) (CombBank& bank,
+                                   const float* input,
+                                   const float* damping,
+                                   const float* feedback,
+                                   float* const* outputs,
+                                   int numSamples) noexcept;
+
+// The same, with every line fed back through its CombBank::DecayFilters
+using DecayCombBankFunction = void (*) (CombBank& bank, const float* input, float* const* outputs, int numSamples) noexcept;
+
+// Channel counts the comb bank is compiled for, with maxLinesPerChannel combs
+// per channel: mono, stereo, quad, 5.1 and 7.1.4
+inline constexpr int combBankChannelCounts[] { 1, 2, 4, 6, 12 };
+
+struct Table
+{
+    const char* name {};
+
+    // Indexed by channel count, null for counts not in combBankChannelCounts
+    CombBankFunction combBanks[ProcessingLimits::maxChannels + 1] {};
+
+    // One channel of combs fed a mono input. outputs[0] sums the output taps
+    // and outputs[1] the lines read at their second taps
+    CombBankFunction monoToStereoCombBank {};
+
+    // The same two with decay filters, same indexing
+    DecayCombBankFunction decayCombBanks[ProcessingLimits::maxChannels + 1] {};
+    DecayCombBankFunction decayMonoToStereoCombBank {};
+
+    // In place
+    void (*allPass) (AllPass& allPass, float* samples, int numSamples) noexcept {};
+
+    // Magnitudes of interleaved complex bins
+    void (*magnitudes) (const float* interleaved, float* dest, int numBins) noexcept {};
+
+    // scope[i] = max (magnitudes[bins[i]], previous[i] * decay)
+    void (*peakHold) (const float* magnitudes,
+                      const int32_t* bins,
+                      const float* previous,
+                      float decay,
+                      float* scope,
+                      int numPoints) noexcept {};
+
+    // A sparse FIR, output[i] = sum of gains[k] * input[i + offsets[k]] over
+    // the taps. The offsets are at most zero, input holds history before
+    // input[0] back to the lowest one
+    void (*sparseFir) (const float* input,
+                       const int32_t* offsets,
+                       const float* gains,
+                       int numTaps,
+                       float* output,
+                       int numSamples) noexcept {};
+};
+
+// The fastest variant this CPU supports that matched the scalar reference
+// in a self-test. The first call runs the detection and the self-test and
+// allocates; later calls just return the table.
+const Table& getBest();
+
+// Float delay lines, plain C++
+const Table& getScalar();
+
+// Per-ISA tables, null when the variant isn't built for this architecture.
+// Only call one after checking the CPU supports it.
+const Table* getSse2();
+const Table* getAvx2();
+const Table* getAvx512();
+const Table* getNeon();
+
+} // namespace SimdKernels
@@ -0,0 +1,21 @@
+#include "SimdKernels.h"
+#include "SimdVectors.h"
+
+#if SIMD_KERNELS_AVX2
+    #include "SimdKernelsImpl.h"
+#endif
+
+namespace SimdKernels
+{
+
+const Table* getAvx2()
+{
+#if SIMD_KERNELS_AVX2
+    static constexpr Table table { makeTable<Avx2Vector, Avx2Vector> ("AVX2") };
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace SimdKernels
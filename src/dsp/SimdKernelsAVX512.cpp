@@ -0,0 +1,21 @@
+#include "SimdKernels.h"
+#include "SimdVectors.h"
+
+#if SIMD_KERNELS_AVX512
+    #include "SimdKernelsImpl.h"
+#endif
+
+namespace SimdKernels
+{
+
+const Table* getAvx512()
+{
+#if SIMD_KERNELS_AVX512
+    static constexpr Table table { makeTable<Avx512CombVector, Avx512Vector> ("AVX-512") };
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace SimdKernels
@@ -0,0 +1,427 @@
+#pragma once
+
+#include "SimdKernels.h"
+#include <utility>
+
+// Kernel bodies shared by the per-ISA translation units. Each of them
+// includes this with its own vector type providing the operations used
+// below. Everything here has internal linkage, so each ISA gets its own
+// copy compiled with its own flags.
+namespace SimdKernels
+{
+namespace
+{
+
+// Channels and Lines are compile-time constants, so every loop below has a
+// fixed trip count and the per-group state can stay in registers
+template <typename V, int Channels, int Lines>
+void combBank (CombBank& bank,
+               const float* input,
+               const float* damping,
+               const float* feedback,
+               float* const* outputs,
+               int numSamples) noexcept
+{
+    static_assert (Lines % V::width == 0 && Channels * Lines <= CombBank::maxLanes);
+    constexpr int groupsPerChannel { Lines / V::width };
+    constexpr int numGroups { Channels * groupsPerChannel };
+
+    auto* base = static_cast<float*> (bank.base);
+
+    typename V::Int offsets[static_cast<size_t> (numGroups)], sizes[static_cast<size_t> (numGroups)], indices[static_cast<size_t> (numGroups)];
+    typename V::Float last[static_cast<size_t> (numGroups)];
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        offsets[g] = V::loadInt (bank.offsets + g * V::width);
+        sizes[g] = V::loadInt (bank.sizes + g * V::width);
+        indices[g] = V::loadInt (bank.indices + g * V::width);
+        last[g] = V::load (bank.last + g * V::width);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto in = V::set1 (input[i]);
+        const auto damp = V::set1 (damping[i]);
+        const auto dampInv = V::set1 (1.0f - damping[i]);
+        const auto feedbackLevel = V::set1 (feedback[i]);
+
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            auto sum = V::zero();
+
+            for (int g = ch * groupsPerChannel; g < (ch + 1) * groupsPerChannel; ++g)
+            {
+                const auto address = V::addInt (offsets[g], indices[g]);
+                const auto output = V::gather (base, address);
+
+                last[g] = V::undenormalise (V::add (V::mul (output, dampInv), V::mul (last[g], damp)));
+                V::scatter (base, address, V::undenormalise (V::add (in, V::mul (last[g], feedbackLevel))));
+                indices[g] = V::incrementWrapped (indices[g], sizes[g]);
+
+                sum = V::add (sum, output);
+            }
+
+            outputs[ch][i] = V::sum (sum);
+        }
+    }
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        V::storeInt (bank.indices + g * V::width, indices[g]);
+        V::store (bank.last + g * V::width, last[g]);
+    }
+}
+
+template <typename V, int Lines>
+void monoToStereoCombBank (CombBank& bank,
+                           const float* input,
+                           const float* damping,
+                           const float* feedback,
+                           float* const* outputs,
+                           int numSamples) noexcept
+{
+    static_assert (Lines % V::width == 0 && Lines <= CombBank::maxLanes);
+    constexpr int numGroups { Lines / V::width };
+
+    auto* base = static_cast<float*> (bank.base);
+
+    typename V::Int offsets[static_cast<size_t> (numGroups)], sizes[static_cast<size_t> (numGroups)], indices[static_cast<size_t> (numGroups)], taps[static_cast<size_t> (numGroups)];
+    typename V::Float last[static_cast<size_t> (numGroups)];
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        offsets[g] = V::loadInt (bank.offsets + g * V::width);
+        sizes[g] = V::loadInt (bank.sizes + g * V::width);
+        indices[g] = V::loadInt (bank.indices + g * V::width);
+        taps[g] = V::loadInt (bank.taps + g * V::width);
+        last[g] = V::load (bank.last + g * V::width);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto in = V::set1 (input[i]);
+        const auto damp = V::set1 (damping[i]);
+        const auto dampInv = V::set1 (1.0f - damping[i]);
+        const auto feedbackLevel = V::set1 (feedback[i]);
+
+        auto sum = V::zero();
+        auto tapSum = V::zero();
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            const auto address = V::addInt (offsets[g], indices[g]);
+            const auto output = V::gather (base, address);
+            tapSum = V::add (tapSum, V::gather (base, V::addInt (offsets[g], V::wrap (V::addInt (indices[g], taps[g]), sizes[g]))));
+
+            last[g] = V::undenormalise (V::add (V::mul (output, dampInv), V::mul (last[g], damp)));
+            V::scatter (base, address, V::undenormalise (V::add (in, V::mul (last[g], feedbackLevel))));
+            indices[g] = V::incrementWrapped (indices[g], sizes[g]);
+
+            sum = V::add (sum, output);
+        }
+
+        outputs[0][i] = V::sum (sum);
+        outputs[1][i] = V::sum (tapSum);
+    }
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        V::storeInt (bank.indices + g * V::width, indices[g]);
+        V::store (bank.last + g * V::width, last[g]);
+    }
+}
+
+// A group of lines' decay filters, loaded once per call
+template <typename V>
+struct DecayGroup
+{
+    DecayGroup() = default;
+
+    DecayGroup (const CombBank& bank, int lane) noexcept
+        : b0 (V::load (bank.decay.b0 + lane))
+        , b1 (V::load (bank.decay.b1 + lane))
+        , b2 (V::load (bank.decay.b2 + lane))
+        , a1 (V::load (bank.decay.a1 + lane))
+        , a2 (V::load (bank.decay.a2 + lane))
+        , state1 (V::load (bank.decayState1 + lane))
+        , state2 (V::load (bank.decayState2 + lane))
+    {
+    }
+
+    // Transposed direct form II, the same arithmetic as the scalar kernel
+    typename V::Float process (typename V::Float output) noexcept
+    {
+        const auto filtered = V::add (V::mul (b0, output), state1);
+        state1 = V::undenormalise (V::add (V::sub (V::mul (b1, output), V::mul (a1, filtered)), state2));
+        state2 = V::undenormalise (V::sub (V::mul (b2, output), V::mul (a2, filtered)));
+        return filtered;
+    }
+
+    void store (CombBank& bank, int lane) const noexcept
+    {
+        V::store (bank.decayState1 + lane, state1);
+        V::store (bank.decayState2 + lane, state2);
+    }
+
+    typename V::Float b0, b1, b2, a1, a2, state1, state2;
+};
+
+template <typename V, int Channels, int Lines>
+void decayCombBank (CombBank& bank, const float* input, float* const* outputs, int numSamples) noexcept
+{
+    static_assert (Lines % V::width == 0 && Channels * Lines <= CombBank::maxLanes);
+    constexpr int groupsPerChannel { Lines / V::width };
+    constexpr int numGroups { Channels * groupsPerChannel };
+
+    auto* base = static_cast<float*> (bank.base);
+
+    typename V::Int offsets[static_cast<size_t> (numGroups)], sizes[static_cast<size_t> (numGroups)], indices[static_cast<size_t> (numGroups)];
+    DecayGroup<V> filters[static_cast<size_t> (numGroups)];
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        offsets[g] = V::loadInt (bank.offsets + g * V::width);
+        sizes[g] = V::loadInt (bank.sizes + g * V::width);
+        indices[g] = V::loadInt (bank.indices + g * V::width);
+        filters[g] = DecayGroup<V> (bank, g * V::width);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto in = V::set1 (input[i]);
+
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            auto sum = V::zero();
+
+            for (int g = ch * groupsPerChannel; g < (ch + 1) * groupsPerChannel; ++g)
+            {
+                const auto address = V::addInt (offsets[g], indices[g]);
+                const auto output = V::gather (base, address);
+
+                V::scatter (base, address, V::undenormalise (V::add (in, filters[g].process (output))));
+                indices[g] = V::incrementWrapped (indices[g], sizes[g]);
+
+                sum = V::add (sum, output);
+            }
+
+            outputs[ch][i] = V::sum (sum);
+        }
+    }
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        V::storeInt (bank.indices + g * V::width, indices[g]);
+        filters[g].store (bank, g * V::width);
+    }
+}
+
+template <typename V, int Lines>
+void decayMonoToStereoCombBank (CombBank& bank, const float* input, float* const* outputs, int numSamples) noexcept
+{
+    static_assert (Lines % V::width == 0 && Lines <= CombBank::maxLanes);
+    constexpr int numGroups { Lines / V::width };
+
+    auto* base = static_cast<float*> (bank.base);
+
+    typename V::Int offsets[static_cast<size_t> (numGroups)], sizes[static_cast<size_t> (numGroups)], indices[static_cast<size_t> (numGroups)], taps[static_cast<size_t> (numGroups)];
+    DecayGroup<V> filters[static_cast<size_t> (numGroups)];
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        offsets[g] = V::loadInt (bank.offsets + g * V::width);
+        sizes[g] = V::loadInt (bank.sizes + g * V::width);
+        indices[g] = V::loadInt (bank.indices + g * V::width);
+        taps[g] = V::loadInt (bank.taps + g * V::width);
+        filters[g] = DecayGroup<V> (bank, g * V::width);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto in = V::set1 (input[i]);
+
+        auto sum = V::zero();
+        auto tapSum = V::zero();
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            const auto address = V::addInt (offsets[g], indices[g]);
+            const auto output = V::gather (base, address);
+            tapSum = V::add (tapSum, V::gather (base, V::addInt (offsets[g], V::wrap (V::addInt (indices[g], taps[g]), sizes[g]))));
+
+            V::scatter (base, address, V::undenormalise (V::add (in, filters[g].process (output))));
+            indices[g] = V::incrementWrapped (indices[g], sizes[g]);
+
+            sum = V::add (sum, output);
+        }
+
+        outputs[0][i] = V::sum (sum);
+        outputs[1][i] = V::sum (tapSum);
+    }
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        V::storeInt (bank.indices + g * V::width, indices[g]);
+        filters[g].store (bank, g * V::width);
+    }
+}
+
+template <typename V>
+void allPass (AllPass& allPass, float* samples, int numSamples) noexcept
+{
+    auto* buffer = static_cast<float*> (allPass.buffer);
+    const auto half = V::set1 (0.5f);
+
+    // Up to the next wrap every sample reads a slot that was written before
+    // this run started, so the segment is element-wise
+    while (numSamples > 0)
+    {
+        const auto segment = numSamples < allPass.size - allPass.index ? numSamples : allPass.size - allPass.index;
+        auto* delayed = buffer + allPass.index;
+        int i = 0;
+
+        for (; i + V::width <= segment; i += V::width)
+        {
+            const auto input = V::load (samples + i);
+            const auto bufferedValue = V::load (delayed + i);
+            V::store (delayed + i, V::undenormalise (V::add (input, V::mul (bufferedValue, half))));
+            V::store (samples + i, V::sub (bufferedValue, input));
+        }
+
+        for (; i < segment; ++i)
+        {
+            const auto input = samples[i];
+            const auto bufferedValue = delayed[i];
+            delayed[i] = V::undenormalise (input + bufferedValue * 0.5f);
+            samples[i] = bufferedValue - input;
+        }
+
+        allPass.index += segment;
+
+        if (allPass.index >= allPass.size)
+            allPass.index = 0;
+
+        samples += segment;
+        numSamples -= segment;
+    }
+}
+
+template <typename V>
+void magnitudes (const float* interleaved, float* dest, int numBins) noexcept
+{
+    int i = 0;
+
+    for (; i + V::width <= numBins; i += V::width)
+        V::store (dest + i, V::sqrt (V::sumOfSquaredPairs (interleaved + 2 * i)));
+
+    for (; i < numBins; ++i)
+    {
+        const auto re = interleaved[2 * i];
+        const auto im = interleaved[2 * i + 1];
+        dest[i] = V::sqrt (re * re + im * im);
+    }
+}
+
+template <typename V>
+void peakHold (const float* magnitudes,
+               const int32_t* bins,
+               const float* previous,
+               float decay,
+               float* scope,
+               int numPoints) noexcept
+{
+    const auto decayFactor = V::set1 (decay);
+    int i = 0;
+
+    for (; i + V::width <= numPoints; i += V::width)
+        V::store (scope + i, V::max (V::gather (magnitudes, V::loadInt (bins + i)), V::mul (V::load (previous + i), decayFactor)));
+
+    for (; i < numPoints; ++i)
+    {
+        const auto held = previous[i] * decay;
+        scope[i] = magnitudes[bins[i]] > held ? magnitudes[bins[i]] : held;
+    }
+}
+
+// Vectorised across samples rather than taps: for a run of outputs every
+// tap adds a contiguous stretch of the input, so the taps are gathered with
+// plain unaligned loads and no horizontal sums. Four vectors of outputs stay
+// in registers while the taps go by
+template <typename V>
+void sparseFir (const float* input,
+                const int32_t* offsets,
+                const float* gains,
+                int numTaps,
+                float* output,
+                int numSamples) noexcept
+{
+    int i = 0;
+
+    for (; i + 4 * V::width <= numSamples; i += 4 * V::width)
+    {
+        auto sum0 = V::zero(), sum1 = V::zero(), sum2 = V::zero(), sum3 = V::zero();
+
+        for (int k = 0; k < numTaps; ++k)
+        {
+            const auto* tap = input + i + offsets[k];
+            const auto gain = V::set1 (gains[k]);
+            sum0 = V::add (sum0, V::mul (V::load (tap), gain));
+            sum1 = V::add (sum1, V::mul (V::load (tap + V::width), gain));
+            sum2 = V::add (sum2, V::mul (V::load (tap + 2 * V::width), gain));
+            sum3 = V::add (sum3, V::mul (V::load (tap + 3 * V::width), gain));
+        }
+
+        V::store (output + i, sum0);
+        V::store (output + i + V::width, sum1);
+        V::store (output + i + 2 * V::width, sum2);
+        V::store (output + i + 3 * V::width, sum3);
+    }
+
+    for (; i + V::width <= numSamples; i += V::width)
+    {
+        auto sum = V::zero();
+
+        for (int k = 0; k < numTaps; ++k)
+            sum = V::add (sum, V::mul (V::load (input + i + offsets[k]), V::set1 (gains[k])));
+
+        V::store (output + i, sum);
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        float sum = 0.0f;
+
+        for (int k = 0; k < numTaps; ++k)
+            sum += gains[k] * input[i + offsets[k]];
+
+        output[i] = sum;
+    }
+}
+
+template <typename V, size_t... Layouts>
+constexpr void addCombBanks (Table& table, std::index_sequence<Layouts...>) noexcept
+{
+    ((table.combBanks[combBankChannelCounts[Layouts]] = combBank<V, combBankChannelCounts[Layouts], CombBank::maxLinesPerChannel>), ...);
+    ((table.decayCombBanks[combBankChannelCounts[Layouts]] = decayCombBank<V, combBankChannelCounts[Layouts], CombBank::maxLinesPerChannel>), ...);
+}
+
+// CombVector only needs to work on whole groups of a channel's combs;
+// StreamVector runs the element-wise kernels and may be wider
+template <typename CombVector, typename StreamVector>
+constexpr Table makeTable (const char* name) noexcept
+{
+    Table table;
+    table.name = name;
+    addCombBanks<CombVector> (table, std::make_index_sequence<sizeof (combBankChannelCounts) / sizeof (int)> {});
+    table.monoToStereoCombBank = monoToStereoCombBank<CombVector, CombBank::maxLinesPerChannel>;
+    table.decayMonoToStereoCombBank = decayMonoToStereoCombBank<CombVector, CombBank::maxLinesPerChannel>;
+    table.allPass = allPass<StreamVector>;
+    table.magnitudes = magnitudes<StreamVector>;
+    table.peakHold = peakHold<StreamVector>;
+    table.sparseFir = sparseFir<StreamVector>;
+    return table;
+}
+
+} // namespace
+} // namespace SimdKernels
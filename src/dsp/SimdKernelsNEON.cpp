@@ -0,0 +1,21 @@
+#include "SimdKernels.h"
+#include "SimdVectors.h"
+
+#if SIMD_KERNELS_NEON
+    #include "SimdKernelsImpl.h"
+#endif
+
+namespace SimdKernels
+{
+
+const Table* getNeon()
+{
+#if SIMD_KERNELS_NEON
+    static constexpr Table table { makeTable<NeonVector, NeonVector> ("NEON") };
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace SimdKernels
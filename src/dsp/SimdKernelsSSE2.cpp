@@ -0,0 +1,21 @@
+#include "SimdKernels.h"
+#include "SimdVectors.h"
+
+#if SIMD_KERNELS_SSE2
+    #include "SimdKernelsImpl.h"
+#endif
+
+namespace SimdKernels
+{
+
+const Table* getSse2()
+{
+#if SIMD_KERNELS_SSE2
+    static constexpr Table table { makeTable<Sse2Vector, Sse2Vector> ("SSE2") };
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace SimdKernels
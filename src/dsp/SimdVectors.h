@@ -0,0 +1,335 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SIMD_KERNELS_SSE2 1
+    #include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+    #define SIMD_KERNELS_AVX2 1
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+    #define SIMD_KERNELS_AVX512 1
+#endif
+
+#if defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    #define SIMD_KERNELS_NEON 1
+    #include <arm_neon.h>
+#endif
+
+// Vector types for SimdKernelsImpl.h. Only the ISA translation units include
+// this, and each sees just the types its compiler flags allow. Everything
+// has internal linkage and uses intrinsics only, so no inline code compiled
+// for one ISA can end up shared with another.
+namespace SimdKernels
+{
+namespace
+{
+
+#if SIMD_KERNELS_SSE2
+
+struct Sse2Vector
+{
+    static constexpr int width { 4 };
+    using Float = __m128;
+    using Int = __m128i;
+
+    static Float zero() noexcept { return _mm_setzero_ps(); }
+    static Float set1 (float x) noexcept { return _mm_set1_ps (x); }
+    static Float load (const float* p) noexcept { return _mm_loadu_ps (p); }
+    static void store (float* p, Float x) noexcept { _mm_storeu_ps (p, x); }
+    static Float add (Float a, Float b) noexcept { return _mm_add_ps (a, b); }
+    static Float sub (Float a, Float b) noexcept { return _mm_sub_ps (a, b); }
+    static Float mul (Float a, Float b) noexcept { return _mm_mul_ps (a, b); }
+    static Float max (Float a, Float b) noexcept { return _mm_max_ps (a, b); }
+    static Float sqrt (Float x) noexcept { return _mm_sqrt_ps (x); }
+    static float sqrt (float x) noexcept { return _mm_cvtss_f32 (_mm_sqrt_ss (_mm_set_ss (x))); }
+
+    // Same as JUCE_UNDENORMALISE on Intel
+    static Float undenormalise (Float x) noexcept
+    {
+        const auto offset = _mm_set1_ps (0.1f);
+        return _mm_sub_ps (_mm_add_ps (x, offset), offset);
+    }
+
+    static float undenormalise (float x) noexcept
+    {
+        x += 0.1f;
+        x -= 0.1f;
+        return x;
+    }
+
+    static Int loadInt (const int32_t* p) noexcept { return _mm_loadu_si128 (reinterpret_cast<const __m128i*> (p)); }
+    static void storeInt (int32_t* p, Int x) noexcept { _mm_storeu_si128 (reinterpret_cast<__m128i*> (p), x); }
+    static Int addInt (Int a, Int b) noexcept { return _mm_add_epi32 (a, b); }
+
+    static Int incrementWrapped (Int index, Int size) noexcept
+    {
+        const auto next = _mm_add_epi32 (index, _mm_set1_epi32 (1));
+        return _mm_and_si128 (next, _mm_cmplt_epi32 (next, size));
+    }
+
+    // index - size where index >= size
+    static Int wrap (Int index, Int size) noexcept
+    {
+        return _mm_sub_epi32 (index, _mm_andnot_si128 (_mm_cmplt_epi32 (index, size), size));
+    }
+
+    static Float gather (const float* base, Int index) noexcept
+    {
+        alignas (16) int32_t i[width];
+        storeInt (i, index);
+        return _mm_setr_ps (base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+    }
+
+    static void scatter (float* base, Int index, Float x) noexcept
+    {
+        alignas (16) int32_t i[width];
+        alignas (16) float values[width];
+        storeInt (i, index);
+        store (values, x);
+
+        for (int lane = 0; lane < width; ++lane)
+            base[i[lane]] = values[lane];
+    }
+
+    static float sum (Float x) noexcept
+    {
+        const auto pairs = _mm_add_ps (x, _mm_movehl_ps (x, x));
+        return _mm_cvtss_f32 (_mm_add_ss (pairs, _mm_shuffle_ps (pairs, pairs, 1)));
+    }
+
+    // re * re + im * im of width interleaved complex values
+    static Float sumOfSquaredPairs (const float* p) noexcept
+    {
+        const auto a = _mm_loadu_ps (p);
+        const auto b = _mm_loadu_ps (p + 4);
+        const auto re = _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+        const auto im = _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+        return _mm_add_ps (_mm_mul_ps (re, re), _mm_mul_ps (im, im));
+    }
+};
+
+#endif
+
+#if SIMD_KERNELS_AVX2
+
+struct Avx2Vector
+{
+    static constexpr int width { 8 };
+    using Float = __m256;
+    using Int = __m256i;
+
+    static Float zero() noexcept { return _mm256_setzero_ps(); }
+    static Float set1 (float x) noexcept { return _mm256_set1_ps (x); }
+    static Float load (const float* p) noexcept { return _mm256_loadu_ps (p); }
+    static void store (float* p, Float x) noexcept { _mm256_storeu_ps (p, x); }
+    static Float add (Float a, Float b) noexcept { return _mm256_add_ps (a, b); }
+    static Float sub (Float a, Float b) noexcept { return _mm256_sub_ps (a, b); }
+    static Float mul (Float a, Float b) noexcept { return _mm256_mul_ps (a, b); }
+    static Float max (Float a, Float b) noexcept { return _mm256_max_ps (a, b); }
+    static Float sqrt (Float x) noexcept { return _mm256_sqrt_ps (x); }
+    static float sqrt (float x) noexcept { return _mm_cvtss_f32 (_mm_sqrt_ss (_mm_set_ss (x))); }
+
+    static Float undenormalise (Float x) noexcept
+    {
+        const auto offset = _mm256_set1_ps (0.1f);
+        return _mm256_sub_ps (_mm256_add_ps (x, offset), offset);
+    }
+
+    static float undenormalise (float x) noexcept
+    {
+        x += 0.1f;
+        x -= 0.1f;
+        return x;
+    }
+
+    static Int loadInt (const int32_t* p) noexcept { return _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (p)); }
+    static void storeInt (int32_t* p, Int x) noexcept { _mm256_storeu_si256 (reinterpret_cast<__m256i*> (p), x); }
+    static Int addInt (Int a, Int b) noexcept { return _mm256_add_epi32 (a, b); }
+
+    static Int incrementWrapped (Int index, Int size) noexcept
+    {
+        const auto next = _mm256_add_epi32 (index, _mm256_set1_epi32 (1));
+        return _mm256_and_si256 (next, _mm256_cmpgt_epi32 (size, next));
+    }
+
+    static Int wrap (Int index, Int size) noexcept
+    {
+        return _mm256_sub_epi32 (index, _mm256_andnot_si256 (_mm256_cmpgt_epi32 (size, index), size));
+    }
+
+    static Float gather (const float* base, Int index) noexcept { return _mm256_i32gather_ps (base, index, 4); }
+
+    // AVX2 has no scatter
+    static void scatter (float* base, Int index, Float x) noexcept
+    {
+        alignas (32) int32_t i[width];
+        alignas (32) float values[width];
+        storeInt (i, index);
+        store (values, x);
+
+        for (int lane = 0; lane < width; ++lane)
+            base[i[lane]] = values[lane];
+    }
+
+    static float sum (Float x) noexcept
+    {
+        const auto halves = _mm_add_ps (_mm256_castps256_ps128 (x), _mm256_extractf128_ps (x, 1));
+        const auto pairs = _mm_add_ps (halves, _mm_movehl_ps (halves, halves));
+        return _mm_cvtss_f32 (_mm_add_ss (pairs, _mm_shuffle_ps (pairs, pairs, 1)));
+    }
+
+    static Float sumOfSquaredPairs (const float* p) noexcept
+    {
+        const auto a = _mm256_loadu_ps (p);
+        const auto b = _mm256_loadu_ps (p + 8);
+        const auto re = _mm256_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+        const auto im = _mm256_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+
+        // The shuffles work per 128-bit half, which leaves the bins in
+        // 64-bit pairs ordered 0, 2, 1, 3
+        const auto squares = _mm256_add_ps (_mm256_mul_ps (re, re), _mm256_mul_ps (im, im));
+        return _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (squares), _MM_SHUFFLE (3, 1, 2, 0)));
+    }
+};
+
+#endif
+
+#if SIMD_KERNELS_AVX512
+
+// Without optimisation GCC's scatter and gather macros pass their all-ones
+// mask through a signed cast
+#if defined(__GNUC__) && ! defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wsign-conversion"
+#endif
+
+// A channel has 8 combs, so the comb bank stays 256 bits wide and gains
+// the AVX-512VL scatter
+struct Avx512CombVector : Avx2Vector
+{
+    static void scatter (float* base, Int index, Float x) noexcept { _mm256_i32scatter_ps (base, index, x, 4); }
+};
+
+struct Avx512Vector
+{
+    static constexpr int width { 16 };
+    using Float = __m512;
+    using Int = __m512i;
+
+    static Float zero() noexcept { return _mm512_setzero_ps(); }
+    static Float set1 (float x) noexcept { return _mm512_set1_ps (x); }
+    static Float load (const float* p) noexcept { return _mm512_loadu_ps (p); }
+    static void store (float* p, Float x) noexcept { _mm512_storeu_ps (p, x); }
+    static Float add (Float a, Float b) noexcept { return _mm512_add_ps (a, b); }
+    static Float sub (Float a, Float b) noexcept { return _mm512_sub_ps (a, b); }
+    static Float mul (Float a, Float b) noexcept { return _mm512_mul_ps (a, b); }
+    static Float max (Float a, Float b) noexcept { return _mm512_max_ps (a, b); }
+    static Float sqrt (Float x) noexcept { return _mm512_sqrt_ps (x); }
+    static float sqrt (float x) noexcept { return _mm_cvtss_f32 (_mm_sqrt_ss (_mm_set_ss (x))); }
+
+    static Float undenormalise (Float x) noexcept
+    {
+        const auto offset = _mm512_set1_ps (0.1f);
+        return _mm512_sub_ps (_mm512_add_ps (x, offset), offset);
+    }
+
+    static float undenormalise (float x) noexcept
+    {
+        x += 0.1f;
+        x -= 0.1f;
+        return x;
+    }
+
+    static Int loadInt (const int32_t* p) noexcept { return _mm512_loadu_si512 (p); }
+    static Float gather (const float* base, Int index) noexcept { return _mm512_i32gather_ps (index, base, 4); }
+
+    static Float sumOfSquaredPairs (const float* p) noexcept
+    {
+        const auto a = _mm512_loadu_ps (p);
+        const auto b = _mm512_loadu_ps (p + 16);
+        const auto even = _mm512_setr_epi32 (0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        const auto odd = _mm512_setr_epi32 (1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+        const auto re = _mm512_permutex2var_ps (a, even, b);
+        const auto im = _mm512_permutex2var_ps (a, odd, b);
+        return _mm512_add_ps (_mm512_mul_ps (re, re), _mm512_mul_ps (im, im));
+    }
+};
+
+#if defined(__GNUC__) && ! defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif
+
+#if SIMD_KERNELS_NEON
+
+struct NeonVector
+{
+    static constexpr int width { 4 };
+    using Float = float32x4_t;
+    using Int = int32x4_t;
+
+    static Float zero() noexcept { return vdupq_n_f32 (0.0f); }
+    static Float set1 (float x) noexcept { return vdupq_n_f32 (x); }
+    static Float load (const float* p) noexcept { return vld1q_f32 (p); }
+    static void store (float* p, Float x) noexcept { vst1q_f32 (p, x); }
+    static Float add (Float a, Float b) noexcept { return vaddq_f32 (a, b); }
+    static Float sub (Float a, Float b) noexcept { return vsubq_f32 (a, b); }
+    static Float mul (Float a, Float b) noexcept { return vmulq_f32 (a, b); }
+    static Float max (Float a, Float b) noexcept { return vmaxq_f32 (a, b); }
+    static Float sqrt (Float x) noexcept { return vsqrtq_f32 (x); }
+    static float sqrt (float x) noexcept { return vget_lane_f32 (vsqrt_f32 (vdup_n_f32 (x)), 0); }
+
+    // JUCE_UNDENORMALISE is a no-op off Intel, ARM flushes denormals itself
+    static Float undenormalise (Float x) noexcept { return x; }
+    static float undenormalise (float x) noexcept { return x; }
+
+    static Int loadInt (const int32_t* p) noexcept { return vld1q_s32 (p); }
+    static void storeInt (int32_t* p, Int x) noexcept { vst1q_s32 (p, x); }
+    static Int addInt (Int a, Int b) noexcept { return vaddq_s32 (a, b); }
+
+    static Int incrementWrapped (Int index, Int size) noexcept
+    {
+        const auto next = vaddq_s32 (index, vdupq_n_s32 (1));
+        return vandq_s32 (next, vreinterpretq_s32_u32 (vcltq_s32 (next, size)));
+    }
+
+    static Int wrap (Int index, Int size) noexcept
+    {
+        return vsubq_s32 (index, vbicq_s32 (size, vreinterpretq_s32_u32 (vcltq_s32 (index, size))));
+    }
+
+    static Float gather (const float* base, Int index) noexcept
+    {
+        auto x = vdupq_n_f32 (base[vgetq_lane_s32 (index, 0)]);
+        x = vsetq_lane_f32 (base[vgetq_lane_s32 (index, 1)], x, 1);
+        x = vsetq_lane_f32 (base[vgetq_lane_s32 (index, 2)], x, 2);
+        return vsetq_lane_f32 (base[vgetq_lane_s32 (index, 3)], x, 3);
+    }
+
+    static void scatter (float* base, Int index, Float x) noexcept
+    {
+        base[vgetq_lane_s32 (index, 0)] = vgetq_lane_f32 (x, 0);
+        base[vgetq_lane_s32 (index, 1)] = vgetq_lane_f32 (x, 1);
+        base[vgetq_lane_s32 (index, 2)] = vgetq_lane_f32 (x, 2);
+        base[vgetq_lane_s32 (index, 3)] = vgetq_lane_f32 (x, 3);
+    }
+
+    static float sum (Float x) noexcept { return vaddvq_f32 (x); }
+
+    static Float sumOfSquaredPairs (const float* p) noexcept
+    {
+        const auto pairs = vld2q_f32 (p);
+        return vaddq_f32 (vmulq_f32 (pairs.val[0], pairs.val[0]), vmulq_f32 (pairs.val[1], pairs.val[1]));
+    }
+};
+
+#endif
+
+} // namespace
+} // namespace SimdKernels
@@ -0,0 +1,96 @@
+#include "TailResampler.h"
+#include <juce_dsp/juce_dsp.h>
+
+template <HalfbandSteepness Steepness>
+HalfbandKernel<Steepness>::HalfbandKernel()
+{
+    // Transition widths are normalised to the higher of the two rates
+    const auto transitionWidth = Steepness == HalfbandSteepness::steep ? 0.09f : 0.3f;
+    const auto coefficients =
+        juce::dsp::FilterDesign<float>::designFIRLowpassHalfBandEquirippleMethod (transitionWidth, -70.0f);
+
+    // The outer taps have to land on even indices around an odd centre
+    jassert (coefficients->getFilterOrder() == static_cast<size_t> (length - 1) && numTaps % 2 == 0);
+
+    const auto* raw = coefficients->getRawCoefficients();
+
+    for (int i = 0; i < numTaps; ++i)
+        taps[static_cast<size_t> (i)] = raw[2 * i];
+}
+
+template struct HalfbandKernel<HalfbandSteepness::gentle>;
+template struct HalfbandKernel<HalfbandSteepness::steep>;
+
+TailResampler::TailResampler() { reset(); }
+
+void TailResampler::setFactor (int newFactor) noexcept
+{
+    jassert (newFactor == 1 || newFactor == 2 || newFactor == 4);
+
+    if (newFactor != factor)
+    {
+        factor = newFactor;
+        reset();
+    }
+}
+
+void TailResampler::reset() noexcept
+{
+    gentleDecimator.reset();
+    steepDecimator.reset();
+
+    for (auto& interpolator : steepInterpolators)
+        interpolator.reset();
+
+    for (auto& interpolator : gentleInterpolators)
+        interpolator.reset();
+
+    for (auto& channel : pending)
+        channel.fill (0.0f);
+
+    numPending = factor - 1;
+}
+
+int TailResampler::decimate (const float* input, int numSamples, float* reducedRate) noexcept
+{
+    jassert (factor > 1 && numSamples <= maxBlockSize);
+
+    if (factor == 4)
+    {
+        const auto numHalfRate = gentleDecimator.process (input, numSamples, halfRate.data());
+        return steepDecimator.process (halfRate.data(), numHalfRate, reducedRate);
+    }
+
+    return steepDecimator.process (input, numSamples, reducedRate);
+}
+
+void TailResampler::interpolate (const float* const* reducedRate,
+                                 int numReduced,
+                                 float* const* output,
+                                 int numChannels,
+                                 int numSamples) noexcept
+{
+    const auto numAvailable = numPending + numReduced * factor;
+    jassert (numAvailable >= numSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* channelPending = pending[static_cast<size_t> (ch)].data();
+        auto* interpolated = channelPending + numPending;
+
+        if (factor == 4)
+        {
+            steepInterpolators[static_cast<size_t> (ch)].process (reducedRate[ch], numReduced, halfRate.data());
+            gentleInterpolators[static_cast<size_t> (ch)].process (halfRate.data(), 2 * numReduced, interpolated);
+        }
+        else
+        {
+            steepInterpolators[static_cast<size_t> (ch)].process (reducedRate[ch], numReduced, interpolated);
+        }
+
+        std::copy (channelPending, channelPending + numSamples, output[ch]);
+        std::copy (channelPending + numSamples, channelPending + numAvailable, channelPending);
+    }
+
+    numPending = numAvailable - numSamples;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "ProcessingLimits.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+
+enum class HalfbandSteepness
+{
+    gentle, // 2:1 stage whose transition band is well above the audible range
+    steep   // 2:1 stage next to the reduced rate, keeps ~20 kHz at 2x 44.1/48 kHz
+};
+
+// One halfband lowpass in polyphase form. Every other tap of a halfband FIR
+// is zero except the centre one, so at 2:1 each output is a short symmetric
+// FIR over one phase plus the centre tap on the other. The tap count is
+// fixed per steepness so the tap loops unroll.
+template <HalfbandSteepness Steepness>
+struct HalfbandKernel
+{
+    static constexpr int numTaps { Steepness == HalfbandSteepness::steep ? 26 : 8 }; // non-zero outer taps
+    static constexpr int length { 2 * numTaps - 1 };                                 // of the full FIR
+
+    HalfbandKernel();
+
+    // output[k] += sum of taps over samples[k .. k + numTaps - 1]. Taps run in
+    // the outer loop and outputs in the inner one, so the inner loop is plain
+    // element-wise arithmetic the compiler can vectorise. The kernel is
+    // symmetric, so mirrored pairs share a multiply.
+    void accumulate (const float* samples, float* output, int numOutputs) const noexcept
+    {
+        for (int i = 0; i < numTaps / 2; ++i)
+        {
+            const auto tap = taps[static_cast<size_t> (i)];
+            const auto* first = samples + i;
+            const auto* mirrored = samples + numTaps - 1 - i;
+
+            for (int k = 0; k < numOutputs; ++k)
+                output[k] += tap * (first[k] + mirrored[k]);
+        }
+    }
+
+    std::array<float, static_cast<size_t> (numTaps)> taps {};
+};
+
+// Block-wise 2:1 decimator. The input phase carries over between blocks, so
+// any split of a signal into blocks gives the same output.
+template <HalfbandSteepness Steepness, int MaxBlockSize>
+class HalfbandDecimator final
+{
+public:
+    void reset() noexcept
+    {
+        history.fill (0.0f);
+        odd = false;
+    }
+
+    // Returns the number of samples written to output. May run in place
+    int process (const float* input, int numSamples, float* output) noexcept
+    {
+        jassert (numSamples <= MaxBlockSize);
+
+        std::copy (input, input + numSamples, history.begin() + historyLength);
+
+        // Split into the phase the outer taps see and the one the centre tap
+        // sees, starting far enough back to cover the first output's taps
+        const auto* first = history.data() + (odd ? 1 : 0);
+        const auto numOutputs = (numSamples - (odd ? 1 : 0) + 1) / 2;
+
+        for (int k = 0; k < Kernel::numTaps - 1 + numOutputs; ++k)
+        {
+            tapPhase[static_cast<size_t> (k)] = first[2 * k];
+            centrePhase[static_cast<size_t> (k)] = first[2 * k + 1];
+        }
+
+        for (int k = 0; k < numOutputs; ++k)
+            output[k] = 0.5f * centrePhase[static_cast<size_t> (k + (Kernel::numTaps - 2) / 2)];
+
+        kernel.accumulate (tapPhase.data(), output, numOutputs);
+
+        odd = odd != ((numSamples & 1) != 0);
+        std::copy (history.begin() + numSamples, history.begin() + numSamples + historyLength, history.begin());
+        return numOutputs;
+    }
+
+private:
+    using Kernel = HalfbandKernel<Steepness>;
+    static constexpr int historyLength { Kernel::length - 1 };
+    static constexpr int maxPhaseLength { Kernel::numTaps + MaxBlockSize / 2 };
+
+    Kernel kernel;
+    std::array<float, static_cast<size_t> (historyLength + MaxBlockSize + 1)> history {};
+    std::array<float, static_cast<size_t> (maxPhaseLength)> tapPhase {}, centrePhase {};
+    bool odd { false };
+};
+
+// Block-wise 1:2 interpolator, an FIR phase and a pure delay phase
+template <HalfbandSteepness Steepness, int MaxBlockSize>
+class HalfbandInterpolator final
+{
+public:
+    void reset() noexcept { history.fill (0.0f); }
+
+    // Writes 2 * numSamples samples to output
+    void process (const float* input, int numSamples, float* output) noexcept
+    {
+        jassert (numSamples <= MaxBlockSize);
+
+        std::copy (input, input + numSamples, history.begin() + historyLength);
+
+        std::fill_n (filtered.begin(), numSamples, 0.0f);
+        kernel.accumulate (history.data(), filtered.data(), numSamples);
+
+        const auto* delayed = history.data() + historyLength - (Kernel::numTaps - 2) / 2;
+
+        for (int k = 0; k < numSamples; ++k)
+        {
+            output[2 * k] = 2.0f * filtered[static_cast<size_t> (k)];
+            output[2 * k + 1] = delayed[k];
+        }
+
+        std::copy (history.begin() + numSamples, history.begin() + numSamples + historyLength, history.begin());
+    }
+
+private:
+    using Kernel = HalfbandKernel<Steepness>;
+    static constexpr int historyLength { Kernel::numTaps - 1 };
+
+    Kernel kernel;
+    std::array<float, static_cast<size_t> (historyLength + MaxBlockSize)> history {};
+    std::array<float, static_cast<size_t> (MaxBlockSize)> filtered {};
+};
+
+// Runs the reverb tail at 1/2 or 1/4 of the host rate: the tail input is
+// decimated, the network runs on the reduced-rate block, and its output is
+// interpolated back up. The output is primed with factor - 1 samples of
+// silence so that every block can be returned in full.
+class TailResampler final
+{
+public:
+    static constexpr int maxFactor { 4 };
+    static constexpr int maxChannels { ProcessingLimits::maxChannels };
+    static constexpr int maxBlockSize { 256 }; // host-rate samples per call
+
+    TailResampler();
+
+    // Real-time safe. Factor must be 1, 2 or 4
+    void setFactor (int newFactor) noexcept;
+    int getFactor() const noexcept { return factor; }
+
+    void reset() noexcept;
+
+    // Returns the number of reduced-rate samples written. May run in place
+    int decimate (const float* input, int numSamples, float* reducedRate) noexcept;
+
+    // Takes the network output for the last decimate() call and writes
+    // exactly numSamples host-rate samples per channel
+    void interpolate (const float* const* reducedRate,
+                      int numReduced,
+                      float* const* output,
+                      int numChannels,
+                      int numSamples) noexcept;
+
+private:
+    int factor { 1 };
+
+    // At 1/4 rate the gentle stage sits next to the host rate and the steep
+    // one next to the reduced rate; at 1/2 rate only the steep stage is used
+    HalfbandDecimator<HalfbandSteepness::gentle, maxBlockSize> gentleDecimator;
+    HalfbandDecimator<HalfbandSteepness::steep, maxBlockSize> steepDecimator;
+    std::array<HalfbandInterpolator<HalfbandSteepness::steep, maxBlockSize / 2>, maxChannels> steepInterpolators;
+    std::array<HalfbandInterpolator<HalfbandSteepness::gentle, maxBlockSize / 2>, maxChannels> gentleInterpolators;
+
+    // Interpolated samples not returned yet. The factor - 1 the output is
+    // primed with, plus as many again when the decimators end a block
+    // between phases, so at most 2 * (factor - 1) carry over
+    std::array<std::array<float, maxBlockSize + 2 * maxFactor>, maxChannels> pending {};
+    std::array<float, maxBlockSize> halfRate {};
+    int numPending {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TailResampler)
+};
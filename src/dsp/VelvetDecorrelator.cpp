@@ -0,0 +1,81 @@
+#include "VelvetDecorrelator.h"
+#include <cmath>
+#include <cstring>
+
+VelvetDecorrelator::VelvetDecorrelator()
+{
+    const auto decayPerTap = std::pow (10.0f, -decayDb / (20.0f * static_cast<float> (numTaps)));
+
+    for (size_t ch = 0; ch < maxChannels; ++ch)
+    {
+        juce::Random random (0x7e1 + static_cast<juce::int64> (ch));
+        auto envelope = 1.0f;
+        float energy = 0.0f;
+
+        for (size_t k = 0; k < numTaps; ++k)
+        {
+            positions[ch][k] = random.nextFloat();
+            gains[ch][k] = random.nextBool() ? envelope : -envelope;
+            energy += envelope * envelope;
+            envelope *= decayPerTap;
+        }
+
+        for (auto& gain : gains[ch])
+            gain /= std::sqrt (energy);
+    }
+}
+
+void VelvetDecorrelator::allocate (double capacitySampleRate, int maxBlockSize)
+{
+    // Room for as many new samples as history before the oldest has to be
+    // moved back to the front, so that happens at most every other block
+    const auto maxHistory = static_cast<int> (std::ceil (lengthSeconds * capacitySampleRate));
+    history.assign (static_cast<size_t> (2 * maxHistory + maxBlockSize), 0.0f);
+    capacityRate = capacitySampleRate;
+    historyLength = 0;
+    writePosition = 0;
+}
+
+void VelvetDecorrelator::prepare (double sampleRate, int numChannelsToUse) noexcept
+{
+    jassert (sampleRate <= capacityRate);
+    jassert (numChannelsToUse <= maxChannels);
+
+    numChannels = juce::jmin (numChannelsToUse, maxChannels);
+    const auto period = juce::jmin (sampleRate, capacityRate) * lengthSeconds / numTaps;
+    historyLength = static_cast<int> (std::ceil (period * numTaps));
+
+    for (size_t ch = 0; ch < maxChannels; ++ch)
+        for (size_t k = 0; k < numTaps; ++k)
+            offsets[ch][k] = -juce::jmin (historyLength, static_cast<int> ((static_cast<double> (k) + positions[ch][k]) * period));
+
+    reset();
+}
+
+void VelvetDecorrelator::reset() noexcept
+{
+    std::fill (history.begin(), history.end(), 0.0f);
+    writePosition = historyLength;
+}
+
+void VelvetDecorrelator::process (const SimdKernels::Table& kernels,
+                                  const float* input,
+                                  float* const* outputs,
+                                  int numSamples) noexcept
+{
+    jassert (historyLength + numSamples <= static_cast<int> (history.size()));
+
+    if (writePosition + numSamples > static_cast<int> (history.size()))
+    {
+        std::memmove (history.data(), history.data() + writePosition - historyLength, static_cast<size_t> (historyLength) * sizeof (float));
+        writePosition = historyLength;
+    }
+
+    auto* current = history.data() + writePosition;
+    std::copy (input, input + numSamples, current);
+
+    for (size_t ch = 0; ch < static_cast<size_t> (numChannels); ++ch)
+        kernels.sparseFir (current, offsets[ch].data(), gains[ch].data(), numTaps, outputs[ch], numSamples);
+
+    writePosition += numSamples;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ProcessingLimits.h"
+#include "SimdKernels.h"
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// Early reflections from velvet noise: one impulse of random sign per grid
+// period, at a random position within it, under a decaying envelope. Every
+// channel gets its own sequence, so the channels are decorrelated copies of
+// the same input, at the cost of a sparse FIR through SimdKernels::sparseFir.
+// That cost follows the number of impulses, not the length they span.
+//
+// A single history of the mono input serves every channel. It is allocated
+// for a sample rate up front; prepare() only recomputes the tap positions.
+class VelvetDecorrelator final
+{
+public:
+    static constexpr int maxChannels { ProcessingLimits::maxChannels };
+    static constexpr double lengthSeconds { 0.05 };
+    static constexpr int numTaps { 100 }; // per channel, 2000 per second
+    static constexpr float decayDb { 30.0f }; // over lengthSeconds
+
+    // Draws every channel's sequence, the same on every construction
+    VelvetDecorrelator();
+
+    // Not real-time safe. The longest block process() may be given at up to
+    // capacitySampleRate
+    void allocate (double capacitySampleRate, int maxBlockSize);
+
+    // Allocation-free for rates up to the allocated capacity
+    void prepare (double sampleRate, int numChannelsToUse) noexcept;
+    void reset() noexcept;
+
+    // Appends input to the history and writes each channel's reflections of
+    // it, normalised to the input's energy
+    void process (const SimdKernels::Table& kernels, const float* input, float* const* outputs, int numSamples) noexcept;
+
+private:
+    // Unit-free draws per channel: where in its grid period each impulse
+    // sits, from 0 to 1, and its gain with the sign and envelope applied
+    std::array<std::array<float, numTaps>, maxChannels> positions {};
+    std::array<std::array<float, numTaps>, maxChannels> gains {};
+
+    // Taps at the prepared rate, in samples relative to the current one
+    std::array<std::array<int32_t, numTaps>, maxChannels> offsets {};
+
+    std::vector<float> history;
+    int historyLength {}; // samples kept before the write position
+    int writePosition {};
+    int numChannels {};
+    double capacityRate {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VelvetDecorrelator)
+};
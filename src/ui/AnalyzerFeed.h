@@ -0,0 +1,75 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+// Audio-to-UI sample feed for the spectrum analyzer. The processor owns one
+// and pushes into it from the audio thread; every open editor holds a
+// reference and pulls complete analysis frames at its own pace. Neither side
+// takes a lock, so editors can come and go without touching audio processing.
+class AnalyzerFeed final : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<AnalyzerFeed>;
+
+    static constexpr int frameSize = 1 << 13;
+
+    // Samples are published to readers in batches of at least this many, so
+    // hosts calling with tiny blocks don't pay for a release store each time
+    static constexpr int publishInterval = 256;
+
+    AnalyzerFeed() = default;
+
+    void setSampleRate(float newSampleRate) { sampleRate.store(newSampleRate, std::memory_order_relaxed); }
+    float getSampleRate() const { return sampleRate.load(std::memory_order_relaxed); }
+
+    // Audio thread only. Announces how far it is about to write before it
+    // touches the ring, so readers can tell whether a copy raced with it
+    void push(const float* data, int numSamples) noexcept
+    {
+        writingUpTo.store(writeIndex + numSamples, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (int i = 0; i < numSamples; ++i, ++writeIndex)
+            ring[static_cast<size_t>(writeIndex & (capacity - 1))].store(data[i], std::memory_order_relaxed);
+
+        if (writeIndex - writeCount.load(std::memory_order_relaxed) >= publishInterval)
+            writeCount.store(writeIndex, std::memory_order_release);
+    }
+
+    // Copies the newest complete frame into dest if one has finished since
+    // lastFrameEnd, which each reader keeps for itself. Returns false when
+    // there is nothing new or the frame was overwritten while being read.
+    bool readFrame(float* dest, int64_t& lastFrameEnd) const noexcept
+    {
+        const auto count = writeCount.load(std::memory_order_acquire);
+        const auto frameEnd = count - count % frameSize;
+
+        if (frameEnd <= lastFrameEnd || frameEnd == 0)
+            return false;
+
+        const auto frameStart = frameEnd - frameSize;
+
+        for (int i = 0; i < frameSize; ++i)
+            dest[i] = ring[static_cast<size_t>((frameStart + i) & (capacity - 1))].load(std::memory_order_relaxed);
+
+        // Any slot the copy saw rewritten makes the writer's announcement
+        // before it visible here, so the frame is intact if nothing up to
+        // the end of the current push reached back to its start
+        std::atomic_thread_fence(std::memory_order_acquire);
+        lastFrameEnd = frameEnd;
+        return writingUpTo.load(std::memory_order_relaxed) - frameStart <= capacity;
+    }
+
+private:
+    static constexpr int capacity = frameSize * 2;
+
+    std::array<std::atomic<float>, capacity> ring {};
+    std::atomic<int64_t> writeCount { 0 };
+    std::atomic<int64_t> writingUpTo { 0 }; // end of the push in progress, or of the last one
+    int64_t writeIndex { 0 }; // audio thread only, runs ahead of writeCount
+    std::atomic<float> sampleRate { 44100.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyzerFeed)
+};
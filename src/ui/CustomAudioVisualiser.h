@@ -1,36 +1,133 @@
 #pragma once
 
-#include <juce_audio_utils/juce_audio_utils.h>
+#include "FrameScheduler.h"
+#include "MinMaxPyramid.h"
+#include "MyColours.h"
+#include <juce_gui_basics/juce_gui_basics.h>
 
-class CustomAudioVisualiser : public juce::AudioVisualiserComponent
+// Scrolling wet/dry waveform view. The envelopes come from the processor's
+// min/max pyramids, so a frame costs a few bucket reads per pixel whatever
+// the visible time span is. Use the mouse wheel to zoom between
+// minSpanSeconds and maxSpanSeconds.
+class CustomAudioVisualiser : public juce::Component,
+                              private FrameScheduler::Client
 {
 public:
-    CustomAudioVisualiser() : juce::AudioVisualiserComponent(2) // 2 channels for stereo
+    CustomAudioVisualiser(const MinMaxPyramid& dryHistory, const MinMaxPyramid& wetHistory)
+        : dry(dryHistory), wet(wetHistory)
     {
-        setBufferSize(2048);
-        setSamplesPerBlock(1024);
-        setColours(juce::Colour(0xff1a1a1a), juce::Colour(0xff00ff00));
-        setRepaintRate(15);
+        setOpaque(true);
     }
 
+    ~CustomAudioVisualiser() override
+    {
+        setFrameScheduler(nullptr);
+    }
+
+    void setFrameScheduler(FrameScheduler* newScheduler)
+    {
+        if (frameScheduler != nullptr)
+            frameScheduler->removeClient(this);
+
+        frameScheduler = newScheduler;
+
+        if (frameScheduler != nullptr)
+            frameScheduler->addClient(this);
+    }
+
+    void setVisibleSpan(double newSpanSeconds)
+    {
+        spanSeconds = juce::jlimit(minSpanSeconds, maxSpanSeconds, newSpanSeconds);
+        updateEnvelopes();
+        FrameScheduler::requestRepaint(frameScheduler, *this);
+    }
+
+    double getVisibleSpan() const { return spanSeconds; }
+
     void paint(juce::Graphics& g) override
     {
-        auto bounds = getLocalBounds();
-        auto height = bounds.getHeight();
-        auto width = bounds.getWidth();
+        g.drawImageAt(background, 0, 0);
 
-        // Draw background grid
-        g.fillAll(juce::Colour(0xff1a1a1a));
+        const auto height = static_cast<float>(getHeight());
+        const auto centre = height * 0.5f;
 
-        // Draw horizontal grid lines
-        g.setColour(juce::Colours::darkgrey);
-        for (int i = 1; i < 10; ++i)
+        const auto drawEnvelope = [&](const std::vector<juce::Range<float>>& envelope)
         {
-            float y = (height * i) / 10.0f;
-            g.drawHorizontalLine(y, 0, width);
-        }
+            for (int x = 0; x < static_cast<int>(envelope.size()); ++x)
+            {
+                const auto range = envelope[static_cast<size_t>(x)];
+                const auto top = juce::jmax(0.0f, centre - range.getEnd() * centre);
+                const auto bottom = juce::jmin(height, centre - range.getStart() * centre + 1.0f);
+                g.drawVerticalLine(x, top, bottom);
+            }
+        };
+
+        g.setColour(MyColours::midGrey);
+        drawEnvelope(dryEnvelope);
+
+        g.setColour(MyColours::blue.withAlpha(0.8f));
+        drawEnvelope(wetEnvelope);
+    }
+
+    void resized() override
+    {
+        const auto width = juce::jmax(1, getWidth());
+        dryEnvelope.assign(static_cast<size_t>(width), {});
+        wetEnvelope.assign(static_cast<size_t>(width), {});
+
+        // The grid never changes between frames, so render it once per size
+        background = juce::Image(juce::Image::RGB, width, juce::jmax(1, getHeight()), true);
+        juce::Graphics g(background);
+        g.fillAll(juce::Colour(0xff1a1a1a));
+        g.setColour(juce::Colours::darkgrey.withAlpha(0.3f));
+
+        for (int i = 1; i < 4; ++i)
+            g.drawHorizontalLine(getHeight() * i / 4, 0.0f, static_cast<float>(width));
 
-        // Let the base class draw the waveform
-        AudioVisualiserComponent::paint(g);
+        updateEnvelopes();
+    }
+
+    void mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel) override
+    {
+        setVisibleSpan(spanSeconds * std::pow(2.0, -wheel.deltaY * 4.0));
     }
-}; 
\ No newline at end of file
+
+private:
+    static constexpr double minSpanSeconds = 0.01;
+    static constexpr double maxSpanSeconds = 30.0;
+
+    const MinMaxPyramid& dry;
+    const MinMaxPyramid& wet;
+
+    FrameScheduler* frameScheduler = nullptr;
+    double spanSeconds = 2.0;
+    int64_t lastSamplesWritten = -1;
+
+    juce::Image background;
+    std::vector<juce::Range<float>> dryEnvelope;
+    std::vector<juce::Range<float>> wetEnvelope;
+
+    void updateFrame(double) override
+    {
+        if (wet.getNumSamplesWritten() == lastSamplesWritten)
+            return;
+
+        updateEnvelopes();
+        FrameScheduler::requestRepaint(frameScheduler, *this);
+    }
+
+    void updateEnvelopes()
+    {
+        if (wetEnvelope.empty())
+            return;
+
+        const auto numPixels = static_cast<int>(wetEnvelope.size());
+        const auto samplesPerPixel = spanSeconds * wet.getSampleRate() / numPixels;
+
+        lastSamplesWritten = wet.getNumSamplesWritten();
+        dry.read(dryEnvelope.data(), numPixels, samplesPerPixel);
+        wet.read(wetEnvelope.data(), numPixels, samplesPerPixel);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CustomAudioVisualiser)
+};
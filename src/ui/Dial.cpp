@@ -6,7 +6,6 @@ Dial::Dial (juce::RangedAudioParameter& param, juce::UndoManager* um)
     , paramAttachment (audioParam, [&] (float v) { updateValue (v); }, um)
 {
     setWantsKeyboardFocus (true);
-    setRepaintsOnMouseActivity (true);
     setColour (foregroundArcColourId, MyColours::blue);
     setColour (backgroundArcColourId, MyColours::blackGrey);
     setColour (needleColourId, MyColours::midGrey);
@@ -47,14 +46,39 @@ void Dial::resized()
     textBox.setFont (juce::FontOptions { static_cast<float> (textBox.getHeight()) * 0.7f });
 
     mainArea = bounds.expanded (1.0f).withY (bounds.getY() + 1);
+
+    const auto radius = juce::jmin (mainArea.getWidth(), mainArea.getHeight()) * 0.5f;
+    dialArea = juce::Rectangle<float> {}.withSizeKeepingCentre (radius * 2.5f, radius * 2.5f) + mainArea.getCentre();
+
+    createNeedle();
+    invalidateLayers (layerScale);
 }
 
 void Dial::paint (juce::Graphics& g)
 {
-    drawDial (g);
+    if (const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor(); ! juce::approximatelyEqual (scale, layerScale))
+        invalidateLayers (scale);
+
+    if (! trackImage.isValid())
+        trackImage = renderLayer (dialArea, [this] (juce::Graphics& sg) { drawTrack (sg); });
+
+    paintedValue = value;
+    drawDial (g, value);
 
     if (hasKeyboardFocus (true))
-        g.strokePath (borderPath, juce::PathStrokeType { borderThickness });
+    {
+        if (! borderImage.isValid())
+        {
+            borderImage = renderLayer (getLocalBounds().toFloat(),
+                                       [this] (juce::Graphics& sg)
+                                       {
+                                           sg.setColour (findColour (needleColourId));
+                                           sg.strokePath (borderPath, juce::PathStrokeType { borderThickness });
+                                       });
+        }
+
+        g.drawImage (borderImage, getLocalBounds().toFloat());
+    }
 }
 
 void Dial::mouseDown (const juce::MouseEvent& e)
@@ -144,6 +168,8 @@ void Dial::focusLost (FocusChangeType cause)
     repaint();
 }
 
+void Dial::colourChanged() { invalidateLayers (layerScale); }
+
 float Dial::getValue() const { return audioParam.convertFrom0to1 (value); }
 
 void Dial::setTextBoxColour (juce::Colour newColour)
@@ -165,14 +191,52 @@ void Dial::updateValue (float newValue)
     {
         value = audioParam.convertTo0to1 (newValue);
         textBox.setText (audioParam.getCurrentValueAsText(), juce::NotificationType::dontSendNotification);
-        repaint();
+
+        if (! juce::approximatelyEqual (value, paintedValue))
+            FrameScheduler::requestRepaint (frameScheduler, *this, dialArea.getSmallestIntegerContainer());
     }
 }
 
-void Dial::drawDial (juce::Graphics& g)
+juce::Image Dial::renderLayer (juce::Rectangle<float> area,
+                               const std::function<void (juce::Graphics&)>& draw) const
+{
+    const auto scale = juce::jmax (1.0f, layerScale);
+    juce::Image image { juce::Image::ARGB,
+                        juce::jmax (1, juce::roundToInt (area.getWidth() * scale)),
+                        juce::jmax (1, juce::roundToInt (area.getHeight() * scale)),
+                        true };
+
+    juce::Graphics g { image };
+    g.addTransform (juce::AffineTransform::translation (-area.getX(), -area.getY()).scaled (scale));
+    draw (g);
+
+    return image;
+}
+
+void Dial::invalidateLayers (float newScale)
+{
+    layerScale = newScale;
+    trackImage = {};
+    borderImage = {};
+}
+
+void Dial::drawTrack (juce::Graphics& g) const
 {
     const auto radius = juce::jmin (mainArea.getWidth(), mainArea.getHeight()) * 0.5f;
-    const auto toAngle = startAngle + value * (endAngle - startAngle);
+    const auto lineWidth = radius * 0.1f;
+    const auto arcRadius = radius - lineWidth;
+    const auto centre = mainArea.getCentre();
+
+    juce::Path track;
+    track.addCentredArc (centre.x, centre.y, arcRadius, arcRadius, 0.0f, startAngle, endAngle, true);
+    g.setColour (findColour (backgroundArcColourId));
+    g.strokePath (track, juce::PathStrokeType { lineWidth });
+}
+
+void Dial::drawDial (juce::Graphics& g, float normValue)
+{
+    const auto radius = juce::jmin (mainArea.getWidth(), mainArea.getHeight()) * 0.5f;
+    const auto toAngle = startAngle + normValue * (endAngle - startAngle);
     const auto lineWidth = radius * 0.1f;
     const auto arcRadius = radius - lineWidth;
     const auto centre = mainArea.getCentre();
@@ -184,33 +248,39 @@ void Dial::drawDial (juce::Graphics& g)
         space *= restAngle / (space * 2.0f);
     }
 
-    juce::Path backgroundArc;
-    backgroundArc.addCentredArc (centre.x,
-                                 centre.y,
-                                 arcRadius,
-                                 arcRadius,
-                                 0.0f,
-                                 juce::jlimit (startAngle, endAngle, toAngle + space),
-                                 endAngle,
-                                 true);
-    g.setColour (findColour (backgroundArcColourId));
-    g.strokePath (backgroundArc, juce::PathStrokeType { lineWidth });
+    // Only the part of the track past the value shows, after a gap
+    trackClip.clear();
+    trackClip.addPieSegment (dialArea, juce::jlimit (startAngle, endAngle, toAngle + space), endAngle, 0.0f);
 
-    juce::Path valueArc;
+    {
+        const juce::Graphics::ScopedSaveState state { g };
+        g.reduceClipRegion (trackClip);
+        g.drawImage (trackImage, dialArea);
+    }
+
+    valueArc.clear();
     valueArc.addCentredArc (centre.x, centre.y, arcRadius, arcRadius, 0.0f, startAngle, toAngle, true);
     g.setColour (findColour (foregroundArcColourId));
     g.strokePath (valueArc, juce::PathStrokeType { lineWidth });
 
-    juce::Path needle;
+    g.setColour (findColour (needleColourId));
+    g.fillPath (needle, juce::AffineTransform::rotation (toAngle, centre.x, centre.y));
+}
+
+void Dial::createNeedle()
+{
+    const auto radius = juce::jmin (mainArea.getWidth(), mainArea.getHeight()) * 0.5f;
+    const auto lineWidth = radius * 0.1f;
+    const auto centre = mainArea.getCentre();
     const auto needleWidth = lineWidth * 1.5f;
     const auto needleLen = radius + lineWidth * 0.3f;
+
+    needle.clear();
     needle.addRoundedRectangle (centre.x - needleWidth * 0.5f,
                                 centre.y + needleWidth * 0.5f - needleLen,
                                 needleWidth,
                                 needleLen,
                                 needleWidth * 0.5f);
-    g.setColour (findColour (needleColourId));
-    g.fillPath (needle, juce::AffineTransform::rotation (toAngle, centre.x, centre.y));
 }
 
 void Dial::createBorder (const juce::Rectangle<float>& bounds)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "FrameScheduler.h"
 #include "MyColours.h"
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_gui_basics/juce_gui_basics.h>
@@ -30,6 +31,8 @@ public:
     void focusGained (FocusChangeType cause) override;
     void focusLost (FocusChangeType cause) override;
 
+    void colourChanged() override;
+
     float getValue() const;
 
     void setInterval (float newInterval) { interval = newInterval; }
@@ -44,17 +47,25 @@ public:
     // Add a method to temporarily disable parameter updates
     void setParameterUpdatesEnabled(bool enabled) { updatesEnabled = enabled; }
 
+    void setFrameScheduler (FrameScheduler* newScheduler) { frameScheduler = newScheduler; }
+
 private:
     void updateValue (float newValue);
 
-    void drawDial (juce::Graphics& g);
+    void drawTrack (juce::Graphics& g) const;
+    void drawDial (juce::Graphics& g, float normValue);
     void createBorder (const juce::Rectangle<float>& bounds);
+    void createNeedle();
+
+    juce::Image renderLayer (juce::Rectangle<float> area, const std::function<void (juce::Graphics&)>& draw) const;
+    void invalidateLayers (float newScale);
 
     juce::RangedAudioParameter& audioParam;
     juce::ParameterAttachment paramAttachment;
 
     float value {};
     bool updatesEnabled { true };
+    FrameScheduler* frameScheduler { nullptr };
 
     static constexpr auto sensitivity { 0.01f };
     float interval { 1.0f };
@@ -68,6 +79,18 @@ private:
     juce::Path borderPath;
     static constexpr auto borderThickness { 1.5f };
 
+    // The track and the focus border are rendered lazily at the physical
+    // pixel scale they are painted at. A repaint blits the track and draws
+    // the value arc and needle over it, reusing the paths' storage
+    juce::Rectangle<float> dialArea;
+    juce::Image trackImage;
+    juce::Image borderImage;
+    float layerScale {};
+    float paintedValue { -1.0f };
+    juce::Path trackClip;
+    juce::Path valueArc;
+    juce::Path needle;
+
     juce::Label label;
 
     struct TextBox final : public juce::Label
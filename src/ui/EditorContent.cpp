@@ -1,7 +1,7 @@
 #include "EditorContent.h"
 #include "../ParamIDs.h"
 
-EditorContent::EditorContent (PluginProcessor& p, juce::UndoManager& um)
+EditorContent::EditorContent (PluginProcessor& p, juce::UndoManager& um, FrameScheduler& frameScheduler)
     : apvts (p.getPluginState())
     , sizeDial (*apvts.getParameter (ParamIDs::size), &um)
     , dampDial (*apvts.getParameter (ParamIDs::damp), &um)
@@ -18,6 +18,11 @@ EditorContent::EditorContent (PluginProcessor& p, juce::UndoManager& um)
     widthDial.setExplicitFocusOrder (4);
     mixDial.setExplicitFocusOrder (5);
 
+    for (auto* dial : { &sizeDial, &dampDial, &widthDial, &mixDial })
+        dial->setFrameScheduler (&frameScheduler);
+
+    freezeButton.setFrameScheduler (&frameScheduler);
+
     addAndMakeVisible (sizeDial);
     addAndMakeVisible (dampDial);
     addAndMakeVisible (widthDial);
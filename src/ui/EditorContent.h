@@ -10,7 +10,7 @@
 class EditorContent final : public juce::Component
 {
 public:
-    EditorContent (PluginProcessor& p, juce::UndoManager& um);
+    EditorContent (PluginProcessor& p, juce::UndoManager& um, FrameScheduler& frameScheduler);
 
     void resized() override;
     bool keyPressed (const juce::KeyPress& k) override;
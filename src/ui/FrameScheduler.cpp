@@ -0,0 +1,58 @@
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler (juce::Component& rootComponent)
+    : root (rootComponent)
+    , vBlankAttachment (&root, [this] (double timestampSec) { onVBlank (timestampSec); })
+{
+}
+
+void FrameScheduler::addClient (Client* client) { clients.addIfNotAlreadyThere (client); }
+
+void FrameScheduler::removeClient (Client* client) { clients.removeFirstMatchingValue (client); }
+
+void FrameScheduler::markDirty (juce::Component& component) { markDirty (component, component.getLocalBounds()); }
+
+void FrameScheduler::markDirty (juce::Component& component, juce::Rectangle<int> area)
+{
+    if (&component == &root || root.isParentOf (&component))
+        dirtyRegion.add (root.getLocalArea (&component, area));
+    else
+        component.repaint (area);
+}
+
+void FrameScheduler::requestRepaint (FrameScheduler* scheduler, juce::Component& component)
+{
+    requestRepaint (scheduler, component, component.getLocalBounds());
+}
+
+void FrameScheduler::requestRepaint (FrameScheduler* scheduler, juce::Component& component, juce::Rectangle<int> area)
+{
+    if (scheduler != nullptr)
+        scheduler->markDirty (component, area);
+    else
+        component.repaint (area);
+}
+
+void FrameScheduler::onVBlank (double timestampSec)
+{
+    if (! root.isShowing())
+        return;
+
+    if (! juce::Process::isForegroundProcess() && timestampSec - lastFrameTime < 1.0 / backgroundRateHz)
+        return;
+
+    lastFrameTime = timestampSec;
+
+    for (auto* client : clients)
+        client->updateFrame (timestampSec);
+
+    if (dirtyRegion.isEmpty())
+        return;
+
+    dirtyRegion.consolidate();
+
+    for (const auto& area : dirtyRegion)
+        root.repaint (area);
+
+    dirtyRegion.clear();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+// Drives all editor animation and repaints from the display's vertical blank.
+// Clients get one update call per frame, components report the areas they
+// need redrawn, and everything collected during a frame is flushed to the
+// root component in a single pass. Nothing runs while the editor is hidden or
+// minimised, and the rate is throttled while the host is in the background.
+class FrameScheduler final
+{
+public:
+    struct Client
+    {
+        virtual ~Client() = default;
+        virtual void updateFrame (double timestampSec) = 0;
+    };
+
+    explicit FrameScheduler (juce::Component& rootComponent);
+
+    void addClient (Client* client);
+    void removeClient (Client* client);
+
+    void markDirty (juce::Component& component);
+    void markDirty (juce::Component& component, juce::Rectangle<int> area);
+
+    // Repaints through the scheduler when there is one, directly otherwise
+    static void requestRepaint (FrameScheduler* scheduler, juce::Component& component);
+    static void requestRepaint (FrameScheduler* scheduler, juce::Component& component, juce::Rectangle<int> area);
+
+private:
+    void onVBlank (double timestampSec);
+
+    static constexpr double backgroundRateHz { 5.0 };
+
+    juce::Component& root;
+    juce::Array<Client*> clients;
+    juce::RectangleList<int> dirtyRegion;
+    double lastFrameTime {};
+
+    juce::VBlankAttachment vBlankAttachment;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameScheduler)
+};
@@ -75,5 +75,5 @@ bool FreezeButton::keyPressed (const juce::KeyPress& key)
 void FreezeButton::updateState (bool newState)
 {
     state = newState;
-    repaint();
+    FrameScheduler::requestRepaint (frameScheduler, *this);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "FrameScheduler.h"
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 
@@ -26,10 +27,13 @@ public:
 
     bool keyPressed (const juce::KeyPress& key) override;
 
+    void setFrameScheduler (FrameScheduler* newScheduler) { frameScheduler = newScheduler; }
+
 private:
     void updateState (bool newState);
 
     bool state { false };
+    FrameScheduler* frameScheduler { nullptr };
 
     juce::Path iconPath;
     juce::Rectangle<float> iconBounds;
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+// Multi-level min/max history of an audio stream. The audio thread pushes
+// samples, any number of readers on other threads can query a per-pixel
+// envelope for an arbitrary time span. Level n stores one min/max pair per
+// decimation^n samples in a ring, so a reader only ever touches a handful of
+// buckets per pixel no matter how long the visible span is.
+class MinMaxPyramid
+{
+public:
+    static constexpr int numLevels = 8;
+    static constexpr int decimation = 4;
+    static constexpr int capacity = 8192; // buckets per level, power of two
+
+    MinMaxPyramid() : levels(std::make_unique<std::array<Level, numLevels>>())
+    {
+        reset();
+    }
+
+    void setSampleRate(double newSampleRate) { sampleRate.store(newSampleRate, std::memory_order_relaxed); }
+    double getSampleRate() const { return sampleRate.load(std::memory_order_relaxed); }
+
+    // Must not be called concurrently with push()
+    void reset()
+    {
+        for (auto& level : *levels)
+        {
+            level.count.store(0, std::memory_order_release);
+            level.pendingMin = std::numeric_limits<float>::max();
+            level.pendingMax = std::numeric_limits<float>::lowest();
+            level.pendingCount = 0;
+        }
+    }
+
+    // Audio thread only. Folds all channels into one envelope
+    void push(const juce::AudioBuffer<float>& buffer) noexcept
+    {
+        const int numChannels = buffer.getNumChannels();
+        const int numSamples = buffer.getNumSamples();
+
+        if (numChannels == 0)
+            return;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float lo = buffer.getSample(0, i);
+            float hi = lo;
+
+            for (int ch = 1; ch < numChannels; ++ch)
+            {
+                const float sample = buffer.getSample(ch, i);
+                lo = juce::jmin(lo, sample);
+                hi = juce::jmax(hi, sample);
+            }
+
+            addToLevel(0, lo, hi);
+        }
+    }
+
+    int64_t getNumSamplesWritten() const { return (*levels)[0].count.load(std::memory_order_acquire); }
+
+    // Fills one envelope range per pixel covering the most recent
+    // numPixels * samplesPerPixel samples, oldest first. Pixels without
+    // data yet are returned as a zero range.
+    void read(juce::Range<float>* dest, int numPixels, double samplesPerPixel) const
+    {
+        const int levelIndex = getLevelForSamplesPerPixel(samplesPerPixel);
+        const auto& level = (*levels)[static_cast<size_t>(levelIndex)];
+        const double bucketSize = static_cast<double>(bucketSizeForLevel(levelIndex));
+        const double bucketsPerPixel = samplesPerPixel / bucketSize;
+
+        const int64_t end = level.count.load(std::memory_order_acquire);
+        const int64_t oldest = juce::jmax(int64_t { 0 }, end - capacity + 1);
+        const double start = static_cast<double>(end) - bucketsPerPixel * numPixels;
+
+        for (int pixel = 0; pixel < numPixels; ++pixel)
+        {
+            auto first = static_cast<int64_t>(std::floor(start + bucketsPerPixel * pixel));
+            auto last = juce::jmax(first + 1, static_cast<int64_t>(std::floor(start + bucketsPerPixel * (pixel + 1))));
+
+            first = juce::jmax(first, oldest);
+            last = juce::jmin(last, end);
+
+            if (first >= last)
+            {
+                dest[pixel] = {};
+                continue;
+            }
+
+            float lo = std::numeric_limits<float>::max();
+            float hi = std::numeric_limits<float>::lowest();
+
+            for (auto b = first; b < last; ++b)
+            {
+                const auto slot = static_cast<size_t>(b & (capacity - 1));
+                lo = juce::jmin(lo, level.mins[slot].load(std::memory_order_relaxed));
+                hi = juce::jmax(hi, level.maxs[slot].load(std::memory_order_relaxed));
+            }
+
+            dest[pixel] = { lo, hi };
+        }
+    }
+
+private:
+    struct Level
+    {
+        std::array<std::atomic<float>, capacity> mins {};
+        std::array<std::atomic<float>, capacity> maxs {};
+        std::atomic<int64_t> count { 0 };
+
+        // Partially filled bucket of this level, owned by the audio thread
+        float pendingMin {};
+        float pendingMax {};
+        int pendingCount {};
+    };
+
+    static constexpr int bucketSizeForLevel(int levelIndex)
+    {
+        int size = 1;
+
+        for (int i = 0; i < levelIndex; ++i)
+            size *= decimation;
+
+        return size;
+    }
+
+    // Picks the coarsest level that still has at least one bucket per pixel
+    static int getLevelForSamplesPerPixel(double samplesPerPixel)
+    {
+        int levelIndex = 0;
+
+        while (levelIndex + 1 < numLevels && bucketSizeForLevel(levelIndex + 1) <= samplesPerPixel)
+            ++levelIndex;
+
+        return levelIndex;
+    }
+
+    void addToLevel(int levelIndex, float lo, float hi) noexcept
+    {
+        auto& level = (*levels)[static_cast<size_t>(levelIndex)];
+        const auto index = level.count.load(std::memory_order_relaxed);
+        const auto slot = static_cast<size_t>(index & (capacity - 1));
+
+        level.mins[slot].store(lo, std::memory_order_relaxed);
+        level.maxs[slot].store(hi, std::memory_order_relaxed);
+        level.count.store(index + 1, std::memory_order_release);
+
+        if (levelIndex + 1 == numLevels)
+            return;
+
+        auto& next = (*levels)[static_cast<size_t>(levelIndex + 1)];
+        next.pendingMin = juce::jmin(next.pendingMin, lo);
+        next.pendingMax = juce::jmax(next.pendingMax, hi);
+
+        if (++next.pendingCount == decimation)
+        {
+            const auto nextMin = next.pendingMin;
+            const auto nextMax = next.pendingMax;
+            next.pendingMin = std::numeric_limits<float>::max();
+            next.pendingMax = std::numeric_limits<float>::lowest();
+            next.pendingCount = 0;
+
+            addToLevel(levelIndex + 1, nextMin, nextMax);
+        }
+    }
+
+    std::unique_ptr<std::array<Level, numLevels>> levels;
+    std::atomic<double> sampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MinMaxPyramid)
+};
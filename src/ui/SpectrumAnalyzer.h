@@ -1,25 +1,36 @@
 #pragma once
 
+#include "AnalyzerFeed.h"
+#include "FrameScheduler.h"
+#include "../dsp/SimdKernels.h"
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_dsp/juce_dsp.h>
 
 class SpectrumAnalyzer : public juce::Component,
-                        private juce::Timer
+                        private FrameScheduler::Client
 {
 public:
-    SpectrumAnalyzer() : forwardFFT(fftOrder),
+    enum class DisplayMode
+    {
+        spectrum,
+        spectrogram
+    };
+
+    explicit SpectrumAnalyzer(AnalyzerFeed::Ptr feedToUse) : forwardFFT(fftOrder),
                          window(fftSize, juce::dsp::WindowingFunction<float>::hann),
-                         sampleRate(44100.0f)  // Default sample rate
+                         feed(std::move(feedToUse))
     {
+        jassert(feed != nullptr);
+
         // Initialize vectors with proper size and values
-        fifo.resize(fftSize, 0.0f);
         fftData.resize(2 * fftSize, 0.0f);
         scopeData.resize(numPoints, 0.0f);
         freqPoints.resize(numPoints, 0.0f);
         previousScope.resize(numPoints, 0.0f);
+        magnitudes.resize(numBins + 1, 0.0f); // the last slot stays 0 for points outside the spectrum
+        scopeBins.resize(numPoints, numBins);
 
         setOpaque(true);
-        startTimerHz(30);
         
         // Initialize the frequency scale points (logarithmic scale)
         for (int i = 0; i < numPoints; ++i)
@@ -27,62 +38,58 @@ public:
             float freq = 20.0f * std::pow(1000.0f, i / static_cast<float>(numPoints - 1));
             freqPoints[i] = freq;
         }
+
+        // Ring-buffered spectrogram: one column per analysis frame, the write
+        // position wraps instead of the image being scrolled
+        spectrogramImage = juce::Image(juce::Image::ARGB, spectrogramColumns, spectrogramRows, true);
+
+        for (int row = 0; row < spectrogramRows; ++row)
+            spectrogramRowToPoint[static_cast<size_t>(row)] = juce::roundToInt((numPoints - 1) * (1.0f - row / static_cast<float>(spectrogramRows - 1)));
+
+        juce::ColourGradient colourMap(juce::Colour(0xff1a1a1a), 0.0f, 0.0f, juce::Colours::white, 1.0f, 0.0f, false);
+        colourMap.addColour(0.35, juce::Colours::darkblue);
+        colourMap.addColour(0.65, juce::Colours::cyan);
+        colourMap.createLookupTable(colourTable);
+        spectrogramImage.clear(spectrogramImage.getBounds(), juce::Colour(0xff1a1a1a));
     }
 
     ~SpectrumAnalyzer() override
     {
-        // Stop timer before cleanup
-        stopTimer();
-        
-        // Acquire lock to ensure no timer callback is running
-        const juce::SpinLock::ScopedLockType lock(mutex);
-        
-        // Clear all buffers safely
-        fifo.clear();
-        fifo.shrink_to_fit();
-        fftData.clear();
-        fftData.shrink_to_fit();
-        scopeData.clear();
-        scopeData.shrink_to_fit();
-        freqPoints.clear();
-        freqPoints.shrink_to_fit();
-        previousScope.clear();
-        previousScope.shrink_to_fit();
-        
-        // Make sure we're not processing anything
-        nextFFTBlockReady = false;
-        fifoIndex = 0;
+        setFrameScheduler(nullptr);
     }
 
-    void setSampleRate(float newSampleRate)
+    // Analysis and repaints only run while attached to an editor's scheduler
+    void setFrameScheduler(FrameScheduler* newScheduler)
     {
-        const juce::SpinLock::ScopedLockType lock(mutex);
-        sampleRate = newSampleRate;
+        if (frameScheduler != nullptr)
+            frameScheduler->removeClient(this);
+
+        frameScheduler = newScheduler;
+
+        if (frameScheduler != nullptr)
+            frameScheduler->addClient(this);
     }
 
-    void pushBuffer(const float* data, int numSamples)
+    void setDisplayMode(DisplayMode newMode)
     {
-        if (data == nullptr || numSamples <= 0)
-            return;
-
-        const juce::SpinLock::ScopedLockType lock(mutex);
+        displayMode = newMode;
+        FrameScheduler::requestRepaint(frameScheduler, *this);
+    }
 
-        // Copy samples to the fifo buffer
-        for (int i = 0; i < numSamples; ++i)
-        {
-            fifo[fifoIndex] = data[i]; // Write current sample
-            fifoIndex = (fifoIndex + 1) % fftSize; // Move to next position, wrapping around
+    DisplayMode getDisplayMode() const { return displayMode; }
 
-            if (fifoIndex == 0) // If we wrapped around, a full FFT block is ready
-            {
-                nextFFTBlockReady = true;
-            }
-        }
+    void mouseDown(const juce::MouseEvent&) override
+    {
+        setDisplayMode(displayMode == DisplayMode::spectrum ? DisplayMode::spectrogram : DisplayMode::spectrum);
     }
 
     void paint(juce::Graphics& g) override
     {
-        const juce::SpinLock::ScopedLockType lock(mutex);
+        if (displayMode == DisplayMode::spectrogram)
+        {
+            paintSpectrogram(g);
+            return;
+        }
 
         g.fillAll(juce::Colour(0xff1a1a1a));
 
@@ -216,75 +223,68 @@ public:
 private:
     static constexpr int fftOrder = 13;  // Reverted to 13 for better resolution
     static constexpr int fftSize = 1 << fftOrder; // Now 8192
+    static_assert(fftSize == AnalyzerFeed::frameSize);
     static constexpr int numPoints = 1024; // Increased for better resolution and mapping
     static constexpr float decayFactor = 0.7f;
+    static constexpr int spectrogramColumns = 256;
+    static constexpr int spectrogramRows = 256;
+    static constexpr int colourTableSize = 256;
+    static constexpr double updateRateHz = 30.0;
 
     juce::dsp::FFT forwardFFT;
     juce::dsp::WindowingFunction<float> window;
-    std::vector<float> fifo;
+    AnalyzerFeed::Ptr feed;
     std::vector<float> fftData;
     std::vector<float> scopeData;
     std::vector<float> freqPoints;
     std::vector<float> previousScope;
-    
-    float sampleRate;
-    int fifoIndex = 0;
-    bool nextFFTBlockReady = false;
-    juce::SpinLock mutex;
+
+    static constexpr int numBins = fftSize / 2 + 1;
+    const SimdKernels::Table& kernels = SimdKernels::getBest();
+    std::vector<float> magnitudes;
+    std::vector<int32_t> scopeBins; // magnitude bin each scope point reads
+    float scopeBinsSampleRate = 0.0f;
+
+    int64_t lastFrameEnd = 0;
     float displayOffsetDB = -60.0f; // Changed to -60.0f for more offset
 
-    void timerCallback() override
+    FrameScheduler* frameScheduler = nullptr;
+    double lastUpdateTime = 0.0;
+
+    DisplayMode displayMode = DisplayMode::spectrum;
+    juce::Image spectrogramImage;
+    int spectrogramWriteColumn = 0;
+    std::array<int, spectrogramRows> spectrogramRowToPoint {};
+    juce::PixelARGB colourTable[colourTableSize];
+
+    void updateFrame(double timestampSec) override
     {
-        // Acquire lock for thread safety
-        const juce::SpinLock::ScopedLockType lock(mutex);
+        // The display may refresh faster than the analysis rate the decay is tuned for
+        if (timestampSec - lastUpdateTime < 1.0 / updateRateHz)
+            return;
+
+        lastUpdateTime = timestampSec;
 
         // Only perform FFT if a new block is ready
-        if (nextFFTBlockReady)
+        if (feed->readFrame(fftData.data(), lastFrameEnd))
         {
-            // Copy fifo data to fftData, then apply windowing
-            juce::FloatVectorOperations::copy(fftData.data(), fifo.data(), fftSize);
+            // Apply windowing to the frame copied out of the feed
             window.multiplyWithWindowingTable(fftData.data(), fftSize);
 
             // Perform forward FFT
             forwardFFT.performRealOnlyForwardTransform(fftData.data());
 
-            // Reset the flag immediately to avoid re-processing the same data
-            nextFFTBlockReady = false;
-
-            // Process FFT data to get magnitudes
-            std::vector<float> currentMagnitudes(fftSize / 2 + 1);
-
-            currentMagnitudes[0] = fftData[0];
-            if (fftSize > 1)
-                currentMagnitudes[fftSize / 2] = fftData[1];
+            // The real-only transform leaves numBins interleaved complex bins
+            kernels.magnitudes(fftData.data(), magnitudes.data(), numBins);
 
-            for (int i = 1; i < fftSize / 2; ++i)
-            {
-                currentMagnitudes[i] = std::sqrt(fftData[i * 2] * fftData[i * 2] +
-                                                 fftData[i * 2 + 1] * fftData[i * 2 + 1]);
-            }
-            
             // Map raw magnitudes to scopeData (logarithmic frequency scale)
             // and apply smoothing/decay
-            const float binWidth = sampleRate / fftSize;
-
-            for (int i = 0; i < numPoints; ++i)
-            {
-                const float freq = freqPoints[i];
-                const int bin = static_cast<int>(freq / binWidth);
-
-                if (bin >= 0 && bin < currentMagnitudes.size())
-                {
-                    scopeData[i] = juce::jmax(currentMagnitudes[bin], previousScope[i] * decayFactor);
-                }
-                else
-                {
-                    scopeData[i] = previousScope[i] * decayFactor;
-                }
-            }
+            updateScopeBins();
+            kernels.peakHold(magnitudes.data(), scopeBins.data(), previousScope.data(), decayFactor, scopeData.data(), numPoints);
 
             juce::FloatVectorOperations::copy(previousScope.data(), scopeData.data(), numPoints);
-            repaint();
+            writeSpectrogramColumn();
+            FrameScheduler::requestRepaint(frameScheduler, *this);
         }
         else // If no new block is ready, apply decay only
         {
@@ -293,7 +293,74 @@ private:
                 scopeData[i] = previousScope[i] * decayFactor;
             }
             juce::FloatVectorOperations::copy(previousScope.data(), scopeData.data(), numPoints);
-            repaint();
+
+            // The spectrogram only changes when a new column is written
+            if (displayMode == DisplayMode::spectrum)
+                FrameScheduler::requestRepaint(frameScheduler, *this);
+        }
+    }
+
+    void updateScopeBins()
+    {
+        const auto sampleRate = feed->getSampleRate();
+
+        if (juce::exactlyEqual(sampleRate, scopeBinsSampleRate))
+            return;
+
+        scopeBinsSampleRate = sampleRate;
+        const float binWidth = sampleRate / fftSize;
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const int bin = static_cast<int>(freqPoints[static_cast<size_t>(i)] / binWidth);
+            scopeBins[static_cast<size_t>(i)] = bin >= 0 && bin < numBins ? bin : numBins;
+        }
+    }
+
+    void writeSpectrogramColumn()
+    {
+        const juce::Image::BitmapData pixels(spectrogramImage, spectrogramWriteColumn, 0, 1, spectrogramRows,
+                                             juce::Image::BitmapData::writeOnly);
+
+        for (int row = 0; row < spectrogramRows; ++row)
+        {
+            const float magnitude = scopeData[static_cast<size_t>(spectrogramRowToPoint[static_cast<size_t>(row)])];
+            const float db = magnitude > 0.0f ? juce::Decibels::gainToDecibels(magnitude) + displayOffsetDB : -90.0f;
+            const int index = juce::jlimit(0, colourTableSize - 1, static_cast<int>((db + 90.0f) * (colourTableSize - 1) / 90.0f));
+
+            *reinterpret_cast<juce::PixelARGB*>(pixels.getLinePointer(row)) = colourTable[index];
+        }
+
+        spectrogramWriteColumn = (spectrogramWriteColumn + 1) % spectrogramColumns;
+    }
+
+    void paintSpectrogram(juce::Graphics& g)
+    {
+        const auto bounds = getLocalBounds();
+        const int width = bounds.getWidth();
+        const int height = bounds.getHeight();
+
+        // The oldest column sits at the write position, so the image is drawn in
+        // two pieces split at the wrap point rather than shifting any pixels
+        const int olderColumns = spectrogramColumns - spectrogramWriteColumn;
+        const int olderWidth = juce::roundToInt(width * olderColumns / static_cast<float>(spectrogramColumns));
+
+        g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+        g.drawImage(spectrogramImage, 0, 0, olderWidth, height,
+                    spectrogramWriteColumn, 0, olderColumns, spectrogramRows);
+
+        if (spectrogramWriteColumn > 0)
+            g.drawImage(spectrogramImage, olderWidth, 0, width - olderWidth, height,
+                        0, 0, spectrogramWriteColumn, spectrogramRows);
+
+        // Frequency labels along the left edge
+        g.setColour(juce::Colours::grey.withAlpha(0.5f));
+        const float freqs[] = { 50, 100, 200, 500, 1000, 2000, 5000, 10000 };
+        for (auto freq : freqs)
+        {
+            const float y = static_cast<float>(height) - freqToX(freq, static_cast<float>(height));
+            const juce::String label = freq >= 1000 ? juce::String(freq/1000) + "k" : juce::String(freq);
+            g.drawText(label, 2, static_cast<int>(y - 8), 30, 15, juce::Justification::centredLeft);
         }
     }
 